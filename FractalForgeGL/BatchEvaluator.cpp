@@ -0,0 +1,71 @@
+﻿#include "BatchEvaluator.h"
+#include "FitnessCache.h"
+#include <unordered_map>
+
+// ─── ctor ────────────────────────────────────────────────────────────────────
+BatchEvaluator::BatchEvaluator(int winW, int winH, float fps, int workers)
+    : targetFPS(fps), pool(workers)
+{
+    times.resize(pool.size());
+    for (int w = 0; w < pool.size(); ++w) {
+        renderers.push_back(std::make_unique<CpuMandelbrotRenderer>(winW, winH, 1));
+        renderers.back()->setStageTimes(&times[w]);
+    }
+}
+
+void BatchEvaluator::setDeepZoom(bool on)
+{
+    for (auto& r : renderers) r->setDeepZoom(on);
+}
+void BatchEvaluator::setSubdivision(bool on)
+{
+    for (auto& r : renderers) r->setSubdivision(on);
+}
+RenderStats BatchEvaluator::stats() const
+{
+    RenderStats s;
+    for (auto& r : renderers) {
+        RenderStats w = r->stats();
+        s.computed += w.computed; s.filled += w.filled;
+    }
+    return s;
+}
+StageTimes BatchEvaluator::stageTimes() const
+{
+    StageTimes s;
+    for (auto& t : times) s.add(t);
+    return s;
+}
+
+// ─── batch evaluation ────────────────────────────────────────────────────────
+void BatchEvaluator::evaluate(const std::vector<EvalJob>& jobs,
+    const DeepView& view, std::vector<Fitness>& out,
+    FitnessCache* cache)
+{
+    out.resize(jobs.size());
+
+    // only the first job of each uncached genome is rendered
+    std::vector<int> todo, dupes;
+    std::unordered_map<std::uint64_t, int> pending;   // genome key → rendering job
+    if (cache) cache->setView(view);
+    for (int k = 0; k < (int)jobs.size(); ++k) {
+        if (!cache) { todo.push_back(k); continue; }
+        if (pending.count(jobs[k].g.key())) { dupes.push_back(k); continue; }
+        if (cache->lookup(jobs[k].g, out[k])) continue;
+        pending.emplace(jobs[k].g.key(), k);
+        todo.push_back(k);
+    }
+
+    pool.parallelFor((int)todo.size(), [&](int t, int w) {
+        const EvalJob& job = jobs[todo[t]];
+        CpuMandelbrotRenderer& r = *renderers[w];
+        r.setView(view);
+        r.setGenome(job.g);
+        r.renderOffscreen();
+        out[todo[t]] = measureFitness(r, job.g, targetFPS);
+        });
+
+    if (!cache) return;
+    for (int k : todo) cache->store(jobs[k].g, out[k]);
+    for (int k : dupes) cache->lookup(jobs[k].g, out[k]);
+}
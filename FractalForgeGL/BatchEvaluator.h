@@ -0,0 +1,36 @@
+﻿#pragma once
+#include <memory>
+#include <vector>
+#include "CpuMandelbrotRenderer.h"
+#include "FitnessMetrics.h"
+#include "NSGAII.h"
+#include "ThreadPool.h"
+
+class FitnessCache;
+
+// ─── population-parallel evaluator ───────────────────────────────────────────
+// One single-threaded CPU renderer (with its own pixel buffer) per worker;
+// jobs are stolen one individual at a time, so a generation takes about as
+// long as its slowest individuals rather than the sum of all of them.
+class BatchEvaluator {
+public:
+    BatchEvaluator(int winW, int winH, float targetFPS, int workers = 0);
+
+    int  workers() const { return pool.size(); }
+    void setDeepZoom(bool on);
+    void setSubdivision(bool on);
+    RenderStats stats() const;                   // summed over the workers
+    StageTimes  stageTimes() const;              // ditto (worker-ms)
+
+    // out[k] is the fitness of jobs[k]; with a cache, cached genomes and
+    // duplicates within the batch are filled in without rendering
+    void evaluate(const std::vector<EvalJob>& jobs,
+        const DeepView& view, std::vector<Fitness>& out,
+        FitnessCache* cache = nullptr);
+
+private:
+    float targetFPS;
+    ThreadPool pool;
+    std::vector<std::unique_ptr<CpuMandelbrotRenderer>> renderers;
+    std::vector<StageTimes> times;               // one per renderer
+};
@@ -0,0 +1,414 @@
+﻿#include "CpuMandelbrotRenderer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+// ─── interior check (FS: inBulbs + Brent cycle test) ─────────────────────────
+// Cardioid and period-2 bulb are inset so that no point that escapes in float
+// is rejected; an orbit that returns exactly to its checkpoint repeats forever.
+// Both only ever turn a maxIter result into a maxIter result, sooner.
+static inline bool inBulbs(float x, float y)
+{
+    float xq = x - 0.25f, y2 = y * y, q = xq * xq + y2;
+    if (q * (q + xq) < 0.25f * y2 - 1e-5f) return true;
+    float xb = x + 1.0f;
+    return xb * xb + y2 < 0.0615f;
+}
+
+// ─── span kernels: n pixels, c = (cr[p], ci[p]) ───────────────────────────────
+// any line of pixels (row, column, strided); they write raw iteration counts,
+// as the FS count output does
+template <bool Interior>
+static void spanScalar(const float* cr, const float* ci, int n, int maxIter, int* out)
+{
+    for (int p = 0; p < n; ++p) {
+        float zx = 0.0f, zy = 0.0f, sx = 0.0f, sy = 0.0f;
+        int i = 0, lap = 1, step = 0;
+        if (Interior && inBulbs(cr[p], ci[p])) i = maxIter;
+        for (; i < maxIter && zx * zx + zy * zy < 4.0f; ++i) {
+            float nx = zx * zx - zy * zy + cr[p];
+            zy = 2.0f * zx * zy + ci[p];
+            zx = nx;
+            if (Interior) {
+                if (zx == sx && zy == sy) { i = maxIter; break; }
+                if (++step == lap) { step = 0; lap *= 2; sx = zx; sy = zy; }
+            }
+        }
+        out[p] = i;
+    }
+}
+
+#ifdef FF_X86
+// lanes in `inner` are interior: they leave `live` and report maxIter
+template <bool Interior>
+FF_TARGET("sse2")
+static void spanSSE2(const float* cr, const float* ci, int n, int maxIter, int* out)
+{
+    const __m128 four = _mm_set1_ps(4.0f), two = _mm_set1_ps(2.0f);
+    int p = 0;
+    for (; p + 4 <= n; p += 4) {
+        __m128  vcr = _mm_loadu_ps(cr + p), vci = _mm_loadu_ps(ci + p);
+        __m128  zx = _mm_setzero_ps(), zy = _mm_setzero_ps();
+        __m128  live = _mm_castsi128_ps(_mm_set1_epi32(-1)), inner = _mm_setzero_ps();
+        __m128  sx = zx, sy = zy;
+        __m128i cnt = _mm_setzero_si128();
+        int lap = 1, step = 0;
+        if (Interior) {
+            const __m128 yy = _mm_mul_ps(vci, vci), xq = _mm_sub_ps(vcr, _mm_set1_ps(0.25f));
+            const __m128 q = _mm_add_ps(_mm_mul_ps(xq, xq), yy), xb = _mm_add_ps(vcr, _mm_set1_ps(1.0f));
+            inner = _mm_or_ps(
+                _mm_cmplt_ps(_mm_mul_ps(q, _mm_add_ps(q, xq)),
+                    _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(0.25f), yy), _mm_set1_ps(1e-5f))),
+                _mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(xb, xb), yy), _mm_set1_ps(0.0615f)));
+            live = _mm_andnot_ps(inner, live);
+        }
+        for (int k = 0; k < maxIter; ++k) {
+            __m128 x2 = _mm_mul_ps(zx, zx), y2 = _mm_mul_ps(zy, zy);
+            live = _mm_and_ps(live, _mm_cmplt_ps(_mm_add_ps(x2, y2), four));
+            if (!_mm_movemask_ps(live)) break;
+            cnt = _mm_sub_epi32(cnt, _mm_castps_si128(live));   // +1 where live
+            zy = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(two, zx), zy), vci);
+            zx = _mm_add_ps(_mm_sub_ps(x2, y2), vcr);
+            if (Interior) {
+                __m128 cyc = _mm_and_ps(live, _mm_and_ps(_mm_cmpeq_ps(zx, sx), _mm_cmpeq_ps(zy, sy)));
+                inner = _mm_or_ps(inner, cyc);
+                live = _mm_andnot_ps(cyc, live);
+                if (++step == lap) { step = 0; lap *= 2; sx = zx; sy = zy; }
+            }
+        }
+        alignas(16) int it[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(it), cnt);
+        const int in = _mm_movemask_ps(inner);
+        for (int l = 0; l < 4; ++l) out[p + l] = (in >> l & 1) ? maxIter : it[l];
+    }
+    spanScalar<Interior>(cr + p, ci + p, n - p, maxIter, out + p);
+}
+
+template <bool Interior>
+FF_TARGET("avx2")
+static void spanAVX2(const float* cr, const float* ci, int n, int maxIter, int* out)
+{
+    const __m256 four = _mm256_set1_ps(4.0f), two = _mm256_set1_ps(2.0f);
+    int p = 0;
+    for (; p + 8 <= n; p += 8) {
+        __m256  vcr = _mm256_loadu_ps(cr + p), vci = _mm256_loadu_ps(ci + p);
+        __m256  zx = _mm256_setzero_ps(), zy = _mm256_setzero_ps();
+        __m256  live = _mm256_castsi256_ps(_mm256_set1_epi32(-1)), inner = _mm256_setzero_ps();
+        __m256  sx = zx, sy = zy;
+        __m256i cnt = _mm256_setzero_si256();
+        int lap = 1, step = 0;
+        if (Interior) {
+            const __m256 yy = _mm256_mul_ps(vci, vci), xq = _mm256_sub_ps(vcr, _mm256_set1_ps(0.25f));
+            const __m256 q = _mm256_add_ps(_mm256_mul_ps(xq, xq), yy), xb = _mm256_add_ps(vcr, _mm256_set1_ps(1.0f));
+            inner = _mm256_or_ps(
+                _mm256_cmp_ps(_mm256_mul_ps(q, _mm256_add_ps(q, xq)),
+                    _mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(0.25f), yy), _mm256_set1_ps(1e-5f)), _CMP_LT_OQ),
+                _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(xb, xb), yy), _mm256_set1_ps(0.0615f), _CMP_LT_OQ));
+            live = _mm256_andnot_ps(inner, live);
+        }
+        for (int k = 0; k < maxIter; ++k) {
+            __m256 x2 = _mm256_mul_ps(zx, zx), y2 = _mm256_mul_ps(zy, zy);
+            live = _mm256_and_ps(live, _mm256_cmp_ps(_mm256_add_ps(x2, y2), four, _CMP_LT_OQ));
+            if (!_mm256_movemask_ps(live)) break;
+            cnt = _mm256_sub_epi32(cnt, _mm256_castps_si256(live));
+            zy = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(two, zx), zy), vci);
+            zx = _mm256_add_ps(_mm256_sub_ps(x2, y2), vcr);
+            if (Interior) {
+                __m256 cyc = _mm256_and_ps(live, _mm256_and_ps(
+                    _mm256_cmp_ps(zx, sx, _CMP_EQ_OQ), _mm256_cmp_ps(zy, sy, _CMP_EQ_OQ)));
+                inner = _mm256_or_ps(inner, cyc);
+                live = _mm256_andnot_ps(cyc, live);
+                if (++step == lap) { step = 0; lap *= 2; sx = zx; sy = zy; }
+            }
+        }
+        alignas(32) int it[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(it), cnt);
+        const int in = _mm256_movemask_ps(inner);
+        for (int l = 0; l < 8; ++l) out[p + l] = (in >> l & 1) ? maxIter : it[l];
+    }
+    spanScalar<Interior>(cr + p, ci + p, n - p, maxIter, out + p);
+}
+#endif
+
+// ─── ctor ────────────────────────────────────────────────────────────────────
+CpuMandelbrotRenderer::CpuMandelbrotRenderer(int winW, int winH, int threads)
+    : aspect((float)winW / (float)winH), level(bestSimd()), pool(threads)
+{
+    setResolution(OFF_W, OFF_H);
+}
+
+// ─── per‑frame interface ─────────────────────────────────────────────────────
+void CpuMandelbrotRenderer::setView(float x, float y, float z)
+{
+    DeepView v;
+    v.cx = dd(x); v.cy = dd(y); v.zoom = z;
+    setView(v);
+}
+void CpuMandelbrotRenderer::setView(const DeepView& v)
+{
+    if (v.cx == view.cx && v.cy == view.cy && v.zoom == view.zoom) return;
+    if (pass != PASSES || !scroll(v)) pass = 0;
+    view = v;
+    cx = float(double(v.cx)); cy = float(double(v.cy)); zoom = float(v.zoom);
+}
+void CpuMandelbrotRenderer::setMaxIter(int it)
+{
+    it = std::min(it, MAX_ITER);
+    if (it != maxIter) pass = 0;
+    maxIter = it;
+}
+void CpuMandelbrotRenderer::setSimd(SimdLevel s)
+{
+    level = ((int)s > (int)bestSimd()) ? bestSimd() : s;
+}
+void CpuMandelbrotRenderer::setResolution(int w, int h)
+{
+    if (w == W && h == H && !iters.empty()) return;
+    W = w; H = h;
+    colD.resize(W); rowD.resize(H); colC.resize(W); rowC.resize(H);
+    iters.assign(W * H, 0);
+    pass = 0;
+}
+
+void CpuMandelbrotRenderer::prepare()
+{
+    if (deep) {
+        // offsets from the reference (= view centre) in double; the orbit
+        // only changes with the centre or a larger maxIter
+        orbit.update(view.cx, view.cy, maxIter);
+        for (int x = 0; x < W; ++x) colD[x] = ((x + 0.5) / W - 0.5) * view.zoom * aspect;
+        for (int y = 0; y < H; ++y) rowD[y] = ((y + 0.5) / H - 0.5) * view.zoom;
+    }
+    else {
+        // pixel centres as in the FS, (uv-0.5)*zoom*(aspect,1)+center, but
+        // summed in double and rounded once: c depends only on the pixel's
+        // position in the plane, so a scrolled buffer matches a fresh render
+        const double ox = double(view.cx), oy = double(view.cy);
+        for (int x = 0; x < W; ++x) colC[x] = float(((x + 0.5) / W - 0.5) * view.zoom * aspect + ox);
+        for (int y = 0; y < H; ++y) rowC[y] = float(((y + 0.5) / H - 0.5) * view.zoom + oy);
+    }
+
+    span = interior ? spanScalar<true> : spanScalar<false>;
+#ifdef FF_X86
+    if (level == SimdLevel::AVX2) span = interior ? spanAVX2<true> : spanAVX2<false>;
+    else if (level == SimdLevel::SSE2) span = interior ? spanSSE2<true> : spanSSE2<false>;
+#endif
+}
+
+void CpuMandelbrotRenderer::renderOffscreen()
+{
+    ScopedStage st(stages, Stage::Render);
+    auto t0 = std::chrono::steady_clock::now();
+
+    prepare();
+    pool.parallelFor(tileCount(), [this](int t, int) { renderTile(t); });
+    pass = PASSES;
+    setValid();
+
+    timeMs = std::chrono::duration<float, std::milli>(
+        std::chrono::steady_clock::now() - t0).count();
+}
+
+bool CpuMandelbrotRenderer::refine(float budgetMs)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    auto elapsed = [&t0] {
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    };
+    if (pass == PASSES) {
+        if (vx0 == 0 && vy0 == 0 && vx1 == W && vy1 == H) return true;
+        prepare();                               // scrolled: fill the exposed strips
+        pool.parallelFor(tileCount(), [this](int t, int) { exposeTile(t); });
+        setValid();
+        timeMs = elapsed();
+        return true;
+    }
+
+    if (pass == 0) prepare();
+    do {
+        const int step = PREVIEW_STEP >> pass;
+        if (step == 1 && subdivide)              // coarse samples are recomputed
+            pool.parallelFor(tileCount(), [this](int t, int) { renderTile(t); });
+        else
+            pool.parallelFor(tileCount(), [this, step](int t, int) { refineTile(t, step); });
+        ++pass;
+    } while (pass < PASSES && elapsed() < budgetMs);
+    if (pass == PASSES) setValid();
+
+    timeMs = elapsed();
+    return pass == PASSES;
+}
+
+// ─── tiles ───────────────────────────────────────────────────────────────────
+int CpuMandelbrotRenderer::tileCount() const
+{
+    return ((W + TILE - 1) / TILE) * ((H + TILE - 1) / TILE);
+}
+void CpuMandelbrotRenderer::tileRect(int t, int& x0, int& y0, int& w, int& h) const
+{
+    const int tilesX = (W + TILE - 1) / TILE;
+    x0 = (t % tilesX) * TILE; y0 = (t / tilesX) * TILE;
+    w = (x0 + TILE <= W) ? TILE : W - x0;
+    h = (y0 + TILE <= H) ? TILE : H - y0;
+}
+
+// counts of the n ≤ TILE pixels (x0 + k·dx, y0 + k·dy) into iters; rows,
+// columns and strided grids are all gathered into one SIMD span
+void CpuMandelbrotRenderer::computeLine(int x0, int y0, int dx, int dy, int n)
+{
+    std::uint16_t* out = iters.data() + y0 * W + x0;
+    const int stride = dy * W + dx;
+    if (deep) {
+        for (int k = 0; k < n; ++k)
+            out[k * stride] = std::uint16_t(perturbIterations(orbit, colD[x0 + k * dx], rowD[y0 + k * dy], maxIter));
+        return;
+    }
+    // padded to whole 8-lane vectors with copies of the last pixel: short
+    // subdivision lines would otherwise fall through to the scalar tail
+    float cr[TILE], ci[TILE]; int it[TILE];
+    const int m = (n + 7) & ~7;
+    for (int k = 0; k < m; ++k) {
+        const int j = k < n ? k : n - 1;
+        cr[k] = colC[x0 + j * dx]; ci[k] = rowC[y0 + j * dy];
+    }
+    span(cr, ci, m, maxIter, it);
+    for (int k = 0; k < n; ++k) out[k * stride] = std::uint16_t(it[k]);
+}
+
+void CpuMandelbrotRenderer::renderTile(int t)
+{
+    int x0, y0, w, h;
+    tileRect(t, x0, y0, w, h);
+    if (subdivide) subdivideTile(x0, y0, w, h);
+    else {
+        for (int y = y0; y < y0 + h; ++y) computeLine(x0, y, 1, 0, w);   // row 0 = bottom
+        nComputed += std::uint64_t(w) * h;
+    }
+}
+
+// ─── Mariani–Silver ──────────────────────────────────────────────────────────
+void CpuMandelbrotRenderer::subdivideTile(int x0, int y0, int w, int h)
+{
+    std::uint64_t comp = 0, fill = 0;
+    if (w < 3 || h < 3) {
+        for (int y = y0; y < y0 + h; ++y) computeLine(x0, y, 1, 0, w);
+        comp = std::uint64_t(w) * h;
+    }
+    else {
+        const int xb = x0 + w - 1, yb = y0 + h - 1;
+        computeLine(x0, y0, 1, 0, w);
+        computeLine(x0, yb, 1, 0, w);
+        computeLine(x0, y0 + 1, 0, 1, h - 2);
+        computeLine(xb, y0 + 1, 0, 1, h - 2);
+        comp = 2 * w + 2 * (h - 2);
+        subdivideRect(x0, y0, xb, yb, comp, fill);
+    }
+    nComputed += comp;
+    nFilled += fill;
+}
+
+// border of the inclusive rectangle [xa,xb]×[ya,yb] is already in iters
+void CpuMandelbrotRenderer::subdivideRect(int xa, int ya, int xb, int yb,
+    std::uint64_t& comp, std::uint64_t& fill)
+{
+    const int iw = xb - xa - 1, ih = yb - ya - 1;
+    if (iw < 1 || ih < 1) return;
+
+    const std::uint16_t* it = iters.data();
+    const std::uint16_t v = it[ya * W + xa];
+    bool flat = true;
+    for (int x = xa; x <= xb && flat; ++x) flat = it[ya * W + x] == v && it[yb * W + x] == v;
+    for (int y = ya + 1; y < yb && flat; ++y) flat = it[y * W + xa] == v && it[y * W + xb] == v;
+
+    if (flat) {
+        for (int y = ya + 1; y < yb; ++y) std::fill_n(iters.data() + y * W + xa + 1, iw, v);
+        fill += std::uint64_t(iw) * ih;
+    }
+    else if (iw <= MS_MIN && ih <= MS_MIN) {
+        for (int y = ya + 1; y < yb; ++y) computeLine(xa + 1, y, 1, 0, iw);
+        comp += std::uint64_t(iw) * ih;
+    }
+    else if (iw >= ih) {                         // split the longer side
+        const int xm = (xa + xb) / 2;
+        computeLine(xm, ya + 1, 0, 1, ih);
+        comp += ih;
+        subdivideRect(xa, ya, xm, yb, comp, fill);
+        subdivideRect(xm, ya, xb, yb, comp, fill);
+    }
+    else {
+        const int ym = (ya + yb) / 2;
+        computeLine(xa + 1, ym, 1, 0, iw);
+        comp += iw;
+        subdivideRect(xa, ya, xb, ym, comp, fill);
+        subdivideRect(xa, ym, xb, yb, comp, fill);
+    }
+}
+
+// ─── incremental pan ─────────────────────────────────────────────────────────
+// v differs from the current view by whole pixels at the same zoom: move the
+// counts so new pixel (x,y) holds old pixel (x+sx, y+sy) and
+// shrink the valid rectangle accordingly; false if nothing would survive
+bool CpuMandelbrotRenderer::scroll(const DeepView& v)
+{
+    if (v.zoom != view.zoom) return false;
+    const double fx = double(v.cx - view.cx) / (view.zoom * aspect) * W;
+    const double fy = double(v.cy - view.cy) / view.zoom * H;
+    const double rx = std::round(fx), ry = std::round(fy);
+    if (std::abs(fx - rx) > 1e-3 || std::abs(fy - ry) > 1e-3) return false;
+    const int sx = (int)rx, sy = (int)ry;
+    vx0 = std::max(0, vx0 - sx); vx1 = std::min(W, vx1 - sx);
+    vy0 = std::max(0, vy0 - sy); vy1 = std::min(H, vy1 - sy);
+    if (vx0 >= vx1 || vy0 >= vy1) return false;
+
+    const int n = W - std::abs(sx), dst = sx < 0 ? -sx : 0, src = sx > 0 ? sx : 0;
+    auto moveRow = [&](int y) {
+        std::memmove(&iters[y * W + dst], &iters[(y + sy) * W + src], n * sizeof(std::uint16_t));
+    };
+    if (sy >= 0) for (int y = 0; y + sy < H; ++y) moveRow(y);
+    else for (int y = H - 1; y + sy >= 0; --y) moveRow(y);
+    return true;
+}
+
+// the part of a tile outside the valid rectangle, row by row
+void CpuMandelbrotRenderer::exposeTile(int t)
+{
+    int x0, y0, w, h;
+    tileRect(t, x0, y0, w, h);
+    std::uint64_t comp = 0;
+    for (int y = y0; y < y0 + h; ++y) {
+        if (y < vy0 || y >= vy1) { computeLine(x0, y, 1, 0, w); comp += w; continue; }
+        const int a = std::min(x0 + w, vx0), b = std::max(x0, vx1);
+        if (a > x0) { computeLine(x0, y, 1, 0, a - x0); comp += a - x0; }
+        if (b < x0 + w) { computeLine(b, y, 1, 0, x0 + w - b); comp += x0 + w - b; }
+    }
+    nComputed += comp;
+}
+
+// ─── progressive pass ────────────────────────────────────────────────────────
+// new samples of the `step` grid; each fills its step×step block as a preview
+// (tiles are multiples of PREVIEW_STEP, so the grids line up across tiles)
+void CpuMandelbrotRenderer::refineTile(int t, int step)
+{
+    int x0, y0, w, h;
+    tileRect(t, x0, y0, w, h);
+    std::uint64_t comp = 0;
+    for (int y = y0; y < y0 + h; y += step) {
+        // rows of the previous (2·step) grid already hold every other sample
+        const bool known = step < PREVIEW_STEP && (y - y0) % (2 * step) == 0;
+        const int xs = known ? x0 + step : x0, dx = known ? 2 * step : step;
+        if (xs >= x0 + w) continue;
+        const int n = (x0 + w - 1 - xs) / dx + 1;
+        computeLine(xs, y, dx, 0, n);
+        comp += n;
+
+        if (step == 1) continue;
+        const int bh = (y + step <= y0 + h) ? step : y0 + h - y;
+        for (int k = 0; k < n; ++k) {
+            const int x = xs + k * dx, bw = (x + step <= x0 + w) ? step : x0 + w - x;
+            const std::uint16_t v = iters[y * W + x];
+            for (int by = 0; by < bh; ++by) std::fill_n(iters.data() + (y + by) * W + x, bw, v);
+        }
+    }
+    nComputed += comp;
+}
@@ -0,0 +1,112 @@
+﻿#pragma once
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "RenderBackend.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+
+// ─── CPU escape-time renderer (no GL context needed) ─────────────────────────
+// Evaluates the same loop as the FS shader in 32-bit floats, 8 (AVX2) or 4
+// (SSE2) pixels per step, and spreads 32×32 tiles over a work-stealing pool.
+// Every SIMD level produces the same counts as the scalar reference, provided
+// the compiler does not contract mul+add into FMA (MSVC /fp:precise default,
+// GCC/Clang need -ffp-contract=off).
+// With the interior check on, the same kernels also stop at the analytic
+// cardioid/bulb test and at exact orbit cycles (Brent), as the FS does.
+// Deep-zoom mode iterates per-pixel double deltas against a double-double
+// reference orbit (see DeepZoom.h) instead, one pixel at a time.
+//
+// Two ways to compute fewer pixels, both on raw iteration counts:
+//  - subdivision (Mariani–Silver): a tile's border is computed first; if every
+//    border pixel has the same count the inside is filled with it, otherwise
+//    the rectangle is split in two along a computed line and each half is
+//    checked again. Exact unless a feature is fully enclosed by a flat border.
+//  - progressive passes: refine() computes an 8×8-spaced grid first (each
+//    sample filling its block), then the 4-, 2- and 1-spaced samples, as many
+//    passes as fit the time budget; later calls continue where it stopped.
+//    The last pass is a normal (or subdivided) tile render.
+// Panning a finished frame by whole pixels scrolls the count buffer instead;
+// the next refine() computes only the newly exposed rows and columns. Only a
+// zoom, maxIter or mode change starts the frame over.
+
+// pixels computed vs. filled without iterating, since the last resetStats()
+struct RenderStats {
+    std::uint64_t computed = 0, filled = 0;
+};
+
+class CpuMandelbrotRenderer : public RenderBackend {
+public:
+    // winW/winH only set the aspect ratio, exactly like uRes in the shader;
+    // the buffer is OFF_W×OFF_H unless setResolution() changes it
+    CpuMandelbrotRenderer(int winW, int winH, int threads = 0);
+
+    void setView(float cx, float cy, float zoom) override;
+    void setView(const DeepView& v) override;
+    void setMaxIter(int it) override;
+    void setDeepZoom(bool on) override { if (on != deep) pass = 0; deep = on; }
+    void setInteriorCheck(bool on) override { interior = on; }
+
+    void renderOffscreen() override;             // whole frame at once
+
+    // progressive: next coarse-to-fine passes within budgetMs (at least one);
+    // true once the frame is complete. A view/maxIter change restarts it.
+    bool refine(float budgetMs);
+    bool complete() const { return pass == PASSES; }
+
+    void setResolution(int w, int h) override;   // genome side, or window size
+    int  width() const override { return W; }
+    int  height() const override { return H; }
+    void setSubdivision(bool on) { subdivide = on; }
+
+    RenderStats stats() const { return { nComputed.load(), nFilled.load() }; }
+    void resetStats() { nComputed = 0; nFilled = 0; }
+
+    float lastGpuTimeMs() const override { return timeMs; }
+    const std::uint16_t* iterationPtr() const override { return iters.data(); }
+
+    void      setSimd(SimdLevel s);              // clamped to bestSimd()
+    SimdLevel simd() const { return level; }
+    int       threads() const { return pool.size(); }
+    ThreadPool& threadPool() { return pool; }   // idle between renders
+
+    static constexpr int TILE = 32;
+    static constexpr int PREVIEW_STEP = 8;       // first progressive grid spacing
+    static constexpr int MS_MIN = 6;             // subdivision stops below this
+
+private:
+    using SpanFn = void (*)(const float* cr, const float* ci, int n, int maxIter, int* out);
+    static constexpr int PASSES = 4;             // spacing 8, 4, 2, 1
+
+    float cx = -0.5f, cy = 0.0f, zoom = 1.0f, aspect;
+    int   maxIter = 256;
+    int   W = OFF_W, H = OFF_H;
+    SimdLevel level;
+    bool  interior = false, subdivide = false;
+    SpanFn span = nullptr;                       // picked per frame
+    int   pass = 0;                              // next progressive pass
+    int   vx0 = 0, vy0 = 0, vx1 = 0, vy1 = 0;     // still-valid part after a scroll
+    std::atomic<std::uint64_t> nComputed{ 0 }, nFilled{ 0 };
+
+    bool deep = false;
+    DeepView view;
+    ReferenceOrbit orbit;
+    std::vector<double> colD, rowD;              // per-column/row δc (deep mode)
+
+    float timeMs = 0.0f;
+    std::vector<float> colC, rowC;               // per-column c.x, per-row c.y
+    std::vector<std::uint16_t> iters;            // raw counts, W×H
+    ThreadPool pool;
+
+    void prepare();                              // per-frame tables, orbit, kernel
+    int  tileCount() const;
+    void tileRect(int t, int& x0, int& y0, int& w, int& h) const;
+    void computeLine(int x0, int y0, int dx, int dy, int n);
+    void renderTile(int tile);
+    void subdivideTile(int x0, int y0, int w, int h);
+    void subdivideRect(int xa, int ya, int xb, int yb, std::uint64_t& comp, std::uint64_t& fill);
+    void refineTile(int tile, int step);
+    bool scroll(const DeepView& v);              // whole-pixel pan of a full frame
+    void exposeTile(int tile);
+    void setValid() { vx0 = vy0 = 0; vx1 = W; vy1 = H; }
+};
@@ -0,0 +1,68 @@
+﻿#include "DeepZoom.h"
+#include <cctype>
+#include <cstdlib>
+
+// ─── parsing ─────────────────────────────────────────────────────────────────
+dd ddFromString(const char* s)
+{
+    while (std::isspace((unsigned char)*s)) ++s;
+    bool neg = (*s == '-');
+    if (*s == '-' || *s == '+') ++s;
+
+    dd v; int exp10 = 0; bool frac = false;
+    for (; *s; ++s) {
+        if (*s == '.') { frac = true; continue; }
+        if (!std::isdigit((unsigned char)*s)) break;
+        v = v * dd(10.0) + dd(double(*s - '0'));
+        if (frac) --exp10;
+    }
+    if (*s == 'e' || *s == 'E') exp10 += std::atoi(s + 1);
+
+    dd p(1.0), base(10.0);                       // 10^|exp10| by squaring
+    for (int e = exp10 < 0 ? -exp10 : exp10; e; e >>= 1, base = base * base)
+        if (e & 1) p = p * base;
+    v = (exp10 < 0) ? v / p : v * p;
+    return neg ? -v : v;
+}
+
+// ─── reference orbit ─────────────────────────────────────────────────────────
+bool ReferenceOrbit::update(const dd& x, const dd& y, int maxIter)
+{
+    if (x == cx && y == cy && (escaped || iters >= maxIter)) return false;
+    cx = x; cy = y; iters = maxIter; escaped = false;
+
+    z.clear();
+    z.reserve(2 * (maxIter + 1));
+    dd zx, zy;
+    for (int n = 0; n <= maxIter; ++n) {
+        double hx = double(zx), hy = double(zy);
+        z.push_back(hx); z.push_back(hy);
+        if (hx * hx + hy * hy > 4.0) { escaped = true; break; }
+        dd nx = zx * zx - zy * zy + cx;
+        zy = dd(2.0) * zx * zy + cy;
+        zx = nx;
+    }
+    return true;
+}
+
+// ─── per-pixel delta iteration ───────────────────────────────────────────────
+int perturbIterations(const ReferenceOrbit& ref, double dcx, double dcy, int maxIter)
+{
+    const double* Z = ref.data();
+    const int last = ref.length() - 1;
+    double dx = 0.0, dy = 0.0;
+    int m = 0;
+    for (int i = 0; i < maxIter; ++i) {
+        double zx = Z[2 * m] + dx, zy = Z[2 * m + 1] + dy;
+        double r2 = zx * zx + zy * zy;
+        if (r2 >= 4.0) return i;
+        if (r2 < dx * dx + dy * dy || m == last) { dx = zx; dy = zy; m = 0; }  // rebase
+
+        double tx = 2.0 * Z[2 * m] + dx, ty = 2.0 * Z[2 * m + 1] + dy;
+        double nx = tx * dx - ty * dy + dcx;
+        dy = tx * dy + ty * dx + dcy;
+        dx = nx;
+        ++m;
+    }
+    return maxIter;
+}
@@ -0,0 +1,76 @@
+﻿#pragma once
+#include <cmath>
+#include <vector>
+
+// ─── double-double: ~32 significant digits from an unevaluated hi+lo sum ─────
+struct dd {
+    double hi = 0.0, lo = 0.0;
+    dd() = default;
+    dd(double h) : hi(h) {}
+    dd(double h, double l) : hi(h), lo(l) {}
+    explicit operator double() const { return hi + lo; }
+    bool operator==(const dd& o) const { return hi == o.hi && lo == o.lo; }
+    bool operator!=(const dd& o) const { return !(*this == o); }
+};
+
+inline dd twoSum(double a, double b) {
+    double s = a + b, v = s - a;
+    return { s, (a - (s - v)) + (b - v) };
+}
+inline dd quickTwoSum(double a, double b) { double s = a + b; return { s, b - (s - a) }; }
+
+inline dd operator-(const dd& a) { return { -a.hi, -a.lo }; }
+inline dd operator+(const dd& a, const dd& b) {
+    dd s = twoSum(a.hi, b.hi), t = twoSum(a.lo, b.lo);
+    s = quickTwoSum(s.hi, s.lo + t.hi);
+    return quickTwoSum(s.hi, s.lo + t.lo);
+}
+inline dd operator-(const dd& a, const dd& b) { return a + (-b); }
+inline dd operator*(const dd& a, const dd& b) {
+    double p = a.hi * b.hi;
+    double e = std::fma(a.hi, b.hi, -p) + (a.hi * b.lo + a.lo * b.hi);
+    return quickTwoSum(p, e);
+}
+inline dd operator/(const dd& a, const dd& b) {
+    double q1 = a.hi / b.hi; dd r = a - b * dd(q1);
+    double q2 = r.hi / b.hi; r = r - b * dd(q2);
+    double q3 = r.hi / b.hi;
+    return quickTwoSum(q1, q2) + dd(q3);
+}
+
+// decimal string → dd without rounding through a 53-bit double first
+dd ddFromString(const char* s);
+
+// ─── extended-precision camera ───────────────────────────────────────────────
+// The centre needs more digits than a double once zoom drops below ~1e-13;
+// the zoom itself (a scale) is fine as a double down to ~1e-300.
+struct DeepView {
+    dd     cx{ -0.5 }, cy{ 0.0 };
+    double zoom = 1.0;
+};
+
+// ─── high-precision reference orbit for perturbation rendering ───────────────
+// Z_0 = 0, Z_{n+1} = Z_n² + C iterated in double-double at the view centre
+// and stored as doubles. A pixel at C+δc then iterates only its delta
+//     δ_{n+1} = (2·Z_n + δ_n)·δ_n + δc,      z_n = Z_n + δ_n
+// in plain double (CPU) or float (GPU). When |z_n| < |δ_n| (the delta is about
+// to lose its precision, i.e. a glitch) or the reference runs out, the pixel
+// rebases: δ ← z_n and it restarts from Z_0.
+class ReferenceOrbit {
+public:
+    // recompute for centre (cx,cy) up to maxIter steps unless the stored orbit
+    // already covers it; true if it was recomputed
+    bool update(const dd& cx, const dd& cy, int maxIter);
+
+    int length() const { return (int)z.size() / 2; }
+    const double* data() const { return z.data(); }   // x0,y0,x1,y1,...
+
+private:
+    dd cx, cy;
+    int  iters = -1;          // steps computed
+    bool escaped = false;     // |Z|² > 4 reached before iters
+    std::vector<double> z;
+};
+
+// escape-time count of one pixel, same semantics as the FS loop
+int perturbIterations(const ReferenceOrbit& ref, double dcx, double dcy, int maxIter);
@@ -0,0 +1,61 @@
+﻿#include "FitnessCache.h"
+#include <cmath>
+
+// ─── key ─────────────────────────────────────────────────────────────────────
+std::size_t FitnessCache::KeyHash::operator()(const Key& k) const
+{
+    std::uint64_t h = 1469598103934665603ull;      // FNV-1a over the fields
+    for (std::uint64_t v : { k.g.key(), k.view })
+        h = (h ^ v) * 1099511628211ull;
+    return (std::size_t)h;
+}
+
+// ─── view ────────────────────────────────────────────────────────────────────
+void FitnessCache::setView(const DeepView& v)
+{
+    // same view: zoom on the same log step and centre within half a cell of
+    // `quantum` pixels of the finest fitness buffer from the anchor
+    double half = 0.5 * v.zoom / side * quantum;
+    std::int64_t nz = std::llround(std::log2(v.zoom) * 1024.0);
+    if (nz == qz && std::abs(double(v.cx - anchor.cx)) < half
+        && std::abs(double(v.cy - anchor.cy)) < half) return;
+    anchor = v; qz = nz; ++viewId;
+    map.clear();
+}
+
+// ─── lookup / store ──────────────────────────────────────────────────────────
+bool FitnessCache::lookup(const Genome& g, Fitness& out)
+{
+    auto it = map.find(key(g));
+    if (it == map.end()) { ++nMiss; return false; }
+    ++nHits; out = it->second;
+    return true;
+}
+void FitnessCache::store(const Genome& g, const Fitness& f) { map[key(g)] = f; }
+
+// ─── snapshot ────────────────────────────────────────────────────────────────
+void FitnessCache::save(ByteWriter& out) const
+{
+    out.put(quantum); out.put(anchor); out.put(qz); out.put(viewId);
+    out.put(nHits); out.put(nMiss);
+    out.put(std::uint64_t(map.size()));
+    for (const auto& e : map) { out.put(e.first.g); out.put(e.second); }
+}
+
+void FitnessCache::load(ByteReader& in)
+{
+    float q = 0;
+    in.get(q);
+    if (q != quantum) in.fail();
+    in.get(anchor); in.get(qz); in.get(viewId);
+    in.get(nHits); in.get(nMiss);
+    std::uint64_t n = 0;
+    in.get(n);
+    map.clear();
+    for (std::uint64_t i = 0; i < n && in.ok(); ++i) {
+        Genome g; Fitness f;
+        in.get(g); in.get(f);
+        map[key(g)] = f;
+    }
+    if (!in.ok()) map.clear();
+}
@@ -0,0 +1,53 @@
+﻿#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include "FitnessMetrics.h"
+#include "Snapshot.h"
+
+// ─── objective cache keyed by (genome, quantised view) ───────────────────────
+// Tournament copies, unmutated children, clamped genomes and surviving
+// parents make the same genome come back many times per generation; at a
+// fixed view its render is fully determined, so the stored objective vector
+// is reused instead.
+// Any camera move (beyond the quantum) drops every entry and starts a new
+// view id; the centre is compared in double-double so deep zooms work too.
+class FitnessCache {
+public:
+    // quantum: view resolution as a fraction of one pixel of the finest
+    // fitness buffer rendered, `side` pixels high (GenomeBounds::maxSide)
+    FitnessCache(float quantum, int side) : quantum(quantum), side(side) {}
+
+    void setView(const DeepView& v);               // clears if the view moved
+
+    bool lookup(const Genome& g, Fitness& out);    // counts a hit or a miss
+    void store(const Genome& g, const Fitness& f);
+    void clear() { map.clear(); }
+
+    std::uint64_t hits() const { return nHits; }
+    std::uint64_t misses() const { return nMiss; }
+    std::size_t   size() const { return map.size(); }
+    std::uint64_t view() const { return viewId; }  // changes whenever entries are dropped
+
+    void save(ByteWriter& out) const;              // view, entries and counters
+    void load(ByteReader& in);
+
+private:
+    struct Key {
+        Genome g;
+        std::uint64_t view;
+        bool operator==(const Key& o) const { return g == o.g && view == o.view; }
+    };
+    struct KeyHash {
+        std::size_t operator()(const Key& k) const;
+    };
+
+    float quantum;
+    int   side;
+    DeepView      anchor;                          // view the entries belong to
+    std::int64_t  qz = INT64_MIN;                  // its zoom on a log grid
+    std::uint64_t viewId = 0;
+    std::unordered_map<Key, Fitness, KeyHash> map;
+    std::uint64_t nHits = 0, nMiss = 0;
+
+    Key key(const Genome& g) const { return { g, viewId }; }
+};
@@ -0,0 +1,153 @@
+﻿#include "FitnessMetrics.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// ─── row kernels: edges, Σp, Σp² of row y in one pass ────────────────────────
+// Callers pass y ≥ 1 for edge rows; row 0 only contributes sums.
+static void rowScalar(const std::uint16_t* row, int w, bool edges, int from, PixelStats& s)
+{
+    for (int x = from; x < w; ++x) {
+        std::uint64_t p = row[x];
+        s.sum += p; s.sum2 += p * p;
+        if (edges && x > 0 && (p != row[x - 1] || p != row[x - w])) ++s.edges;
+    }
+}
+
+#ifdef FF_X86
+// counts < 2^15, so the signed 16-bit madds below cannot overflow
+FF_TARGET("sse2")
+static void rowSSE2(const std::uint16_t* row, int w, bool edges, PixelStats& s)
+{
+    const __m128i zero = _mm_setzero_si128(), one = _mm_set1_epi16(1);
+    const __m128i notFirst = _mm_setr_epi16(0, 1, 1, 1, 1, 1, 1, 1);
+    __m128i e = zero, s1 = zero, s2 = zero;      // 16-bit, 32-bit, 64-bit lanes
+    int x = 0;
+    for (; x + 8 <= w; x += 8) {
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+        s1 = _mm_add_epi32(s1, _mm_madd_epi16(p, one));
+        __m128i q = _mm_madd_epi16(p, p);
+        s2 = _mm_add_epi64(s2, _mm_add_epi64(_mm_unpacklo_epi32(q, zero), _mm_unpackhi_epi32(q, zero)));
+        if (!edges) continue;
+        __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x - 1));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x - w));
+        __m128i same = _mm_and_si128(_mm_cmpeq_epi16(p, l), _mm_cmpeq_epi16(p, d));
+        e = _mm_add_epi16(e, _mm_andnot_si128(same, x ? one : notFirst));   // 1 per edge, not column 0
+    }
+    alignas(16) std::uint64_t q[2]; alignas(16) std::uint32_t d[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(d), _mm_madd_epi16(e, one));
+    s.edges += std::uint64_t(d[0]) + d[1] + d[2] + d[3];
+    _mm_store_si128(reinterpret_cast<__m128i*>(d), s1);
+    s.sum += std::uint64_t(d[0]) + d[1] + d[2] + d[3];
+    _mm_store_si128(reinterpret_cast<__m128i*>(q), s2); s.sum2 += q[0] + q[1];
+    rowScalar(row, w, edges, x, s);
+}
+
+FF_TARGET("avx2")
+static void rowAVX2(const std::uint16_t* row, int w, bool edges, PixelStats& s)
+{
+    const __m256i zero = _mm256_setzero_si256(), one = _mm256_set1_epi16(1);
+    const __m256i notFirst = _mm256_setr_epi16(0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1);
+    __m256i e = zero, s1 = zero, s2 = zero;
+    int x = 0;
+    for (; x + 16 <= w; x += 16) {
+        __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x));
+        s1 = _mm256_add_epi32(s1, _mm256_madd_epi16(p, one));
+        __m256i q = _mm256_madd_epi16(p, p);
+        s2 = _mm256_add_epi64(s2, _mm256_add_epi64(_mm256_unpacklo_epi32(q, zero), _mm256_unpackhi_epi32(q, zero)));
+        if (!edges) continue;
+        __m256i l = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x - 1));
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x - w));
+        __m256i same = _mm256_and_si256(_mm256_cmpeq_epi16(p, l), _mm256_cmpeq_epi16(p, d));
+        e = _mm256_add_epi16(e, _mm256_andnot_si256(same, x ? one : notFirst));
+    }
+    alignas(32) std::uint64_t q[4]; alignas(32) std::uint32_t d[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(d), _mm256_madd_epi16(e, one));
+    for (std::uint32_t v : d) s.edges += v;
+    _mm256_store_si256(reinterpret_cast<__m256i*>(d), s1);
+    for (std::uint32_t v : d) s.sum += v;
+    _mm256_store_si256(reinterpret_cast<__m256i*>(q), s2); s.sum2 += q[0] + q[1] + q[2] + q[3];
+    rowScalar(row, w, edges, x, s);
+}
+#endif
+
+// ─── image reductions ────────────────────────────────────────────────────────
+PixelStats pixelStats(const std::uint16_t* px, int w, int y0, int y1, int maxCount)
+{
+    // 16-bit edge lanes and 32-bit Σp lanes hold ≥ 8k pixels per row
+    PixelStats s;
+    SimdLevel lvl = (w <= 8192 && maxCount < 32768) ? bestSimd() : SimdLevel::Scalar;
+    for (int y = y0; y < y1; ++y) {
+        const std::uint16_t* row = px + (std::size_t)y * w;
+#ifdef FF_X86
+        if (lvl == SimdLevel::AVX2) { rowAVX2(row, w, y > 0, s); continue; }
+        if (lvl == SimdLevel::SSE2) { rowSSE2(row, w, y > 0, s); continue; }
+#endif
+        rowScalar(row, w, y > 0, 0, s);
+    }
+    return s;
+}
+
+PixelStats pixelStats(const std::uint16_t* px, int w, int h, int maxCount, ThreadPool* pool)
+{
+    const int band = 64;
+    const int bands = (h + band - 1) / band;
+    if (!pool || pool->size() == 1 || bands == 1) return pixelStats(px, w, 0, h, maxCount);
+
+    std::vector<PixelStats> part(bands);
+    pool->parallelFor(bands, [&](int b, int) {
+        part[b] = pixelStats(px, w, b * band, std::min(h, (b + 1) * band), maxCount);
+        });
+    PixelStats s;
+    for (auto& p : part) s += p;
+    return s;
+}
+
+float pixelVariance(const PixelStats& s, int n, int maxIter)
+{
+    double mean = double(s.sum) / (double(maxIter) * n);
+    double ex2 = double(s.sum2) / (double(maxIter) * maxIter * n);
+    return float(ex2 - mean * mean);
+}
+
+void downsample(const std::uint16_t* px, int w, int h, int s, std::vector<std::uint16_t>& out)
+{
+    const int ow = w / s, oh = h / s, n = s * s;
+    out.resize(std::size_t(ow) * oh);
+    std::vector<std::uint32_t> acc(ow);
+    for (int oy = 0; oy < oh; ++oy) {
+        std::fill(acc.begin(), acc.end(), 0u);
+        for (int y = oy * s; y < (oy + 1) * s; ++y) {
+            const std::uint16_t* row = px + std::size_t(y) * w;
+            for (int ox = 0; ox < ow; ++ox)
+                for (int k = 0; k < s; ++k) acc[ox] += row[ox * s + k];
+        }
+        for (int ox = 0; ox < ow; ++ox)
+            out[std::size_t(oy) * ow + ox] = std::uint16_t((acc[ox] + n / 2) / n);
+    }
+}
+
+// ─── fitness metrics ─────────────────────────────────────────────────────────
+Fitness measureFitness(const RenderBackend& r, const Genome& g, float targetFPS, ThreadPool* pool)
+{
+    ScopedStage st(r.stageTimes(), Stage::Metrics);
+    int W = r.width(), H = r.height();
+    const int maxIter = std::min(g.maxIter, RenderBackend::MAX_ITER);
+    const std::uint16_t* px = r.iterationPtr();
+    std::vector<std::uint16_t> box;
+    if (g.supersample > 1) {
+        downsample(px, W, H, g.supersample, box);
+        px = box.data(); W /= g.supersample; H /= g.supersample;
+    }
+
+    Fitness f;
+    f.fpsErr = std::abs(r.fps() - targetFPS);
+    f.gpuMs = r.lastGpuTimeMs();
+
+    PixelStats s = pixelStats(px, W, H, maxIter, pool);
+    f.boundary = float(s.edges);
+    f.density = pixelVariance(s, W * H, maxIter);
+    return f;
+}
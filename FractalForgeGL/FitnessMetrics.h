@@ -0,0 +1,38 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+#include "RenderBackend.h"
+
+class ThreadPool;
+
+// ─── objective vector of one render ──────────────────────────────────────────
+struct Fitness {
+    float fpsErr = 0, gpuMs = 0, boundary = 0, density = 0;
+};
+
+// ─── raw pixel statistics ────────────────────────────────────────────────────
+// edges: pixels (x≥1, y≥1) whose count differs from their left or lower
+// neighbour; sum / sum2: Σp and Σp² over all pixels, p the iteration count
+struct PixelStats {
+    std::uint64_t edges = 0, sum = 0, sum2 = 0;
+    PixelStats& operator+=(const PixelStats& o) {
+        edges += o.edges; sum += o.sum; sum2 += o.sum2; return *this;
+    }
+};
+
+// one fused pass over rows [y0,y1) of a w-wide count buffer (SSE2/AVX2 when
+// every count is ≤ maxCount < 2^15, scalar otherwise)
+PixelStats pixelStats(const std::uint16_t* px, int w, int y0, int y1, int maxCount);
+// whole image; with a pool, row bands are reduced in parallel
+PixelStats pixelStats(const std::uint16_t* px, int w, int h, int maxCount, ThreadPool* pool = nullptr);
+
+// variance of p/maxIter over n pixels
+float pixelVariance(const PixelStats& s, int n, int maxIter);
+
+// box average of s×s blocks: w×h → (w/s)×(h/s), rounded to nearest
+void downsample(const std::uint16_t* px, int w, int h, int s, std::vector<std::uint16_t>& out);
+
+// score what r rendered last for genome g (timing + its width()×height()
+// counts); with g.supersample > 1 the counts are first averaged down to g.res
+Fitness measureFitness(const RenderBackend& r, const Genome& g, float targetFPS,
+    ThreadPool* pool = nullptr);
@@ -0,0 +1,77 @@
+﻿#include "HeadlessGL.h"
+#include <iostream>
+#ifdef FF_HAVE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+// ─── ctor/dtor ───────────────────────────────────────────────────────────────
+HeadlessGL::HeadlessGL()
+{
+    ready = initEGL() || initGLFW();
+    if (!ready) std::cerr << "Headless GL context failed\n";
+}
+HeadlessGL::~HeadlessGL()
+{
+#ifdef FF_HAVE_EGL
+    if (eglContext) {
+        eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(eglDisplay, eglContext);
+        eglTerminate(eglDisplay);
+    }
+#endif
+    if (window) { glfwDestroyWindow(window); glfwTerminate(); }
+}
+const char* HeadlessGL::rendererName() const
+{
+    return ready ? reinterpret_cast<const char*>(glGetString(GL_RENDERER)) : "none";
+}
+
+// ─── back ends ───────────────────────────────────────────────────────────────
+bool HeadlessGL::initEGL()
+{
+#ifdef FF_HAVE_EGL
+    EGLDisplay d = EGL_NO_DISPLAY;
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (getPlatformDisplay)
+        d = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (d == EGL_NO_DISPLAY) d = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (d == EGL_NO_DISPLAY || !eglInitialize(d, nullptr, nullptr)) return false;
+
+    const EGLint cfgAttr[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    EGLConfig cfg = nullptr; EGLint n = 0;
+    eglChooseConfig(d, cfgAttr, &cfg, 1, &n);
+    eglBindAPI(EGL_OPENGL_API);
+    const EGLint ctxAttr[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4, EGL_CONTEXT_MINOR_VERSION, 1,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE };
+    EGLContext c = eglCreateContext(d, n ? cfg : nullptr, EGL_NO_CONTEXT, ctxAttr);
+    if (c == EGL_NO_CONTEXT || !eglMakeCurrent(d, EGL_NO_SURFACE, EGL_NO_SURFACE, c)) {
+        if (c != EGL_NO_CONTEXT) eglDestroyContext(d, c);
+        eglTerminate(d);
+        return false;
+    }
+    eglDisplay = d; eglContext = c;
+    if (gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) return true;
+    std::cerr << "GLAD failed\n";
+#endif
+    return false;
+}
+
+bool HeadlessGL::initGLFW()
+{
+    if (!glfwInit()) return false;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    window = glfwCreateWindow(64, 64, "headless", nullptr, nullptr);
+    if (!window) { glfwTerminate(); return false; }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    return gladLoadGLLoader((GLADloadproc)glfwGetProcAddress) != 0;
+}
@@ -0,0 +1,26 @@
+﻿#pragma once
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+// ─── window-less GL 4.1 core context for headless GPU runs ───────────────────
+// Built with FF_HAVE_EGL it first tries an EGL surfaceless context, which also
+// works on a software rasteriser with no GPU or display (Mesa llvmpipe,
+// LIBGL_ALWAYS_SOFTWARE=1). Otherwise, or if that fails, it uses an invisible
+// GLFW window.
+class HeadlessGL {
+public:
+    HeadlessGL();
+    ~HeadlessGL();
+
+    bool ok() const { return ready; }
+    const char* rendererName() const;
+
+private:
+    bool ready = false;
+    void* eglDisplay = nullptr;
+    void* eglContext = nullptr;
+    GLFWwindow* window = nullptr;
+
+    bool initEGL();
+    bool initGLFW();
+};
@@ -1 +1,163 @@
 #include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// ─── CSV ─────────────────────────────────────────────────────────────────────
+void CSVLogger::record(const LogRecord& r)
+{
+    file << std::string(r.tag, std::find(r.tag, r.tag + sizeof r.tag, '\0')) << ',' << r.gen;
+    const std::int32_t ints[] = { r.idx, r.maxIter, 0, 0, 0, 0, r.rank, r.res, r.supersample, r.interior };
+    for (int k = 0; k < r.fields; ++k) {
+        file << ',';
+        if (k < 2 || k >= 6) file << ints[k];
+        else if (r.intObj >> (k - 2) & 1) file << std::int32_t(r.obj[k - 2]);
+        else file << r.obj[k - 2];
+    }
+    file << '\n';
+}
+
+// ─── columnar layout ─────────────────────────────────────────────────────────
+namespace {
+    struct Column { std::size_t offset, size; };
+    const Column columns[] = {
+        { offsetof(LogRecord, tag), 8 },
+        { offsetof(LogRecord, gen), 4 },
+        { offsetof(LogRecord, idx), 4 },
+        { offsetof(LogRecord, maxIter), 4 },
+        { offsetof(LogRecord, obj) + 0, 4 },
+        { offsetof(LogRecord, obj) + 4, 4 },
+        { offsetof(LogRecord, obj) + 8, 4 },
+        { offsetof(LogRecord, obj) + 12, 4 },
+        { offsetof(LogRecord, rank), 4 },
+        { offsetof(LogRecord, res), 4 },
+        { offsetof(LogRecord, supersample), 2 },
+        { offsetof(LogRecord, interior), 1 },
+        { offsetof(LogRecord, fields), 1 },
+        { offsetof(LogRecord, intObj), 1 },
+    };
+    constexpr std::uint32_t numColumns = sizeof(columns) / sizeof(columns[0]);
+    constexpr char magic[8] = { 'F', 'F', 'R', 'U', 'N', 'L', 'O', 'G' };
+
+    std::size_t padded(std::size_t bytes) { return (bytes + 7) & ~std::size_t(7); }
+
+    struct Header {
+        char          magic[8];
+        std::uint32_t version, columns;
+        std::uint64_t records;
+        std::uint32_t blockRows, reserved;
+    };
+    static_assert(sizeof(Header) == 32, "header layout");
+}
+
+// ─── writer ──────────────────────────────────────────────────────────────────
+BinaryLogger::BinaryLogger(const std::string& fname, std::size_t capacity)
+    : ring(capacity), file(fname, std::ios::out | std::ios::binary)
+{
+    opened = file.good();
+    if (!opened) { std::cerr << "Cannot open log " << fname << "\n"; return; }
+    Header h{};
+    std::memcpy(h.magic, magic, sizeof magic);
+    h.version = version;
+    h.columns = numColumns;
+    h.blockRows = blockRows;
+    file.write(reinterpret_cast<const char*>(&h), sizeof h);
+    thread = std::thread(&BinaryLogger::writer, this);
+}
+
+BinaryLogger::~BinaryLogger()
+{
+    done.store(true, std::memory_order_release);
+    if (thread.joinable()) thread.join();
+}
+
+void BinaryLogger::writeBlock(const LogRecord* rows, std::uint32_t n)
+{
+    const std::uint32_t head[2] = { n, 0 };
+    file.write(reinterpret_cast<const char*>(head), sizeof head);
+    for (const Column& c : columns) {
+        column.assign(padded(n * c.size), 0);
+        for (std::uint32_t i = 0; i < n; ++i)
+            std::memcpy(&column[i * c.size], reinterpret_cast<const char*>(rows + i) + c.offset, c.size);
+        file.write(column.data(), column.size());
+    }
+}
+
+// drains the ring into blocks; a partial block goes out once the ring has
+// been quiet for a while, so a killed run loses little
+void BinaryLogger::writer()
+{
+    using clock = std::chrono::steady_clock;
+    std::vector<LogRecord> block;
+    block.reserve(blockRows);
+    std::uint64_t records = 0;
+    auto lastWrite = clock::now();
+    auto flush = [&] {
+        writeBlock(block.data(), (std::uint32_t)block.size());
+        records += block.size();
+        block.clear();
+        file.flush();
+        lastWrite = clock::now();
+    };
+
+    LogRecord r;
+    for (;;) {
+        const bool last = done.load(std::memory_order_acquire);
+        while (ring.pop(r)) {
+            block.push_back(r);
+            if (block.size() == blockRows) flush();
+        }
+        if (last) break;
+        if (!block.empty() && clock::now() - lastWrite > std::chrono::milliseconds(500)) flush();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    if (!block.empty()) flush();
+
+    file.seekp(offsetof(Header, records));
+    file.write(reinterpret_cast<const char*>(&records), sizeof records);
+    file.close();
+}
+
+// ─── reader / converter ──────────────────────────────────────────────────────
+bool readBinaryLog(const std::string& fname, std::vector<LogRecord>& out)
+{
+    std::ifstream in(fname, std::ios::binary);
+    Header h{};
+    if (!in.read(reinterpret_cast<char*>(&h), sizeof h) || std::memcmp(h.magic, magic, sizeof magic)) {
+        std::cerr << fname << ": not a run log\n"; return false;
+    }
+    if (h.version != BinaryLogger::version || h.columns != numColumns) {
+        std::cerr << fname << ": log version " << h.version << " not supported\n"; return false;
+    }
+
+    out.clear();
+    std::vector<char> col;
+    std::uint32_t head[2];
+    while (in.read(reinterpret_cast<char*>(head), sizeof head)) {
+        const std::uint32_t n = head[0];
+        const std::size_t first = out.size();
+        out.resize(first + n, LogRecord{});
+        for (const Column& c : columns) {
+            col.resize(padded(n * c.size));
+            if (!in.read(col.data(), col.size())) { std::cerr << fname << ": truncated block\n"; return false; }
+            for (std::uint32_t i = 0; i < n; ++i)
+                std::memcpy(reinterpret_cast<char*>(&out[first + i]) + c.offset, &col[i * c.size], c.size);
+        }
+    }
+    if (h.records && h.records != out.size())
+        std::cerr << fname << ": header says " << h.records << " records, found " << out.size() << "\n";
+    return true;
+}
+
+bool binaryLogToCsv(const std::string& in, const std::string& out)
+{
+    std::vector<LogRecord> rows;
+    if (!readBinaryLog(in, rows)) return false;
+    CSVLogger csv(out);
+    for (const LogRecord& r : rows) csv.record(r);
+    if (!csv.ok()) { std::cerr << "Cannot write " << out << "\n"; return false; }
+    return true;
+}
@@ -1,14 +1,35 @@
 #pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <fstream>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
 #include <iomanip>
+#include "SpscRing.h"
+
+// ─── one run-log row ─────────────────────────────────────────────────────────
+// The CSV columns after gen, by position: idx, maxIter, four objectives,
+// rank, res, supersample, interior. Summary rows (SURR, FIDL) reuse the slots
+// for their own values and may log fewer of them (`fields`); `intObj` marks
+// objective slots that were logged as integers so the CSV reads as before.
+struct LogRecord {
+    char         tag[8];                         // NUL-padded
+    std::int32_t gen, idx, maxIter;
+    float        obj[4];
+    std::int32_t rank, res;
+    std::int16_t supersample;
+    std::uint8_t interior, fields, intObj;
+};
 
 class CSVLogger {
 public:
     explicit CSVLogger(const std::string& fname)
         : file(fname, std::ios::out)
     {
-        file << "tag,gen,idx,maxIter,fpsErr,gpuTimeMs,boundary,density,rank\n";
+        file << "tag,gen,idx,maxIter,fpsErr,gpuTimeMs,boundary,density,rank,res,supersample,interior\n";
     }
     ~CSVLogger() { file.close(); }
 
@@ -19,6 +40,86 @@ public:
         ((file << ',' << xs), ...);
         file << '\n';
     }
+
+    // the row BinaryLogger::row() recorded, as row() would have written it
+    void record(const LogRecord& r);
+
+    bool ok() const { return file.good(); }
+private:
+    std::ofstream file;
+};
+
+// ─── binary run log ──────────────────────────────────────────────────────────
+// row() packs its arguments into a LogRecord (no formatting) and pushes it
+// onto a lock-free ring; a writer thread drains the ring into a columnar
+// file. Pushes only wait if the writer is a whole ring behind.
+//
+// File (native byte order: the same build reads it): 32-byte header
+// {"FFRUNLOG", u32 version, u32 column count, u64 records (0 until closed),
+// u32 rows per block, u32 0}, then blocks of {u32 rows, u32 0, every
+// column's `rows` values back to back, each column padded to 8 bytes}. Columns follow LogRecord's fields in order
+// (obj as four columns), so a reader can map the file and walk the blocks.
+class BinaryLogger {
+public:
+    explicit BinaryLogger(const std::string& fname, std::size_t capacity = 1 << 14);
+    ~BinaryLogger();                             // drains the ring, finishes the file
+    BinaryLogger(const BinaryLogger&) = delete;
+    BinaryLogger& operator=(const BinaryLogger&) = delete;
+
+    bool ok() const { return opened; }
+    long long stalls() const { return stallCount; }   // pushes that found the ring full
+
+    template<typename... Args>
+    void row(const char* tag, int gen, Args... xs)
+    {
+        static_assert(sizeof...(xs) <= 10, "idx .. interior at most");
+        if (!opened) return;
+        LogRecord r{};
+        for (int i = 0; i < 8 && tag[i]; ++i) r.tag[i] = tag[i];
+        r.gen = gen;
+        r.fields = std::uint8_t(sizeof...(xs));
+        int k = 0;
+        (put(r, k++, xs), ...);
+        while (!ring.push(r)) { ++stallCount; std::this_thread::yield(); }
+    }
+
+    static constexpr std::uint32_t version = 1;
+    static constexpr std::uint32_t blockRows = 4096;
+
 private:
+    SpscRing<LogRecord> ring;
     std::ofstream file;
+    bool opened = false;
+    long long stallCount = 0;
+    std::atomic<bool> done{ false };
+    std::thread thread;
+    std::vector<char> column;                    // writer thread's block scratch
+
+    template<typename T>
+    static void put(LogRecord& r, int k, T v)
+    {
+        if (k >= 2 && k < 6) {
+            r.obj[k - 2] = float(v);
+            if (std::is_integral<T>::value) r.intObj |= std::uint8_t(1 << (k - 2));
+            return;
+        }
+        const auto x = std::int32_t(v);
+        switch (k) {
+        case 0: r.idx = x; break;
+        case 1: r.maxIter = x; break;
+        case 6: r.rank = x; break;
+        case 7: r.res = x; break;
+        case 8: r.supersample = std::int16_t(x); break;
+        default: r.interior = std::uint8_t(x); break;
+        }
+    }
+
+    void writer();
+    void writeBlock(const LogRecord* rows, std::uint32_t n);
 };
+
+// every record of a BinaryLogger file; false (with a message) if unreadable
+bool readBinaryLog(const std::string& fname, std::vector<LogRecord>& out);
+
+// the file as the CSV CSVLogger would have written during the run
+bool binaryLogToCsv(const std::string& in, const std::string& out);
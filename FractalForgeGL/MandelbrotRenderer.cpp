@@ -1,36 +1,128 @@
 ﻿#include "MandelbrotRenderer.h"
+#include <cmath>
+#include <cstring>
+#include <initializer_list>
 #include <iostream>
 
 // ─── GLSL sources ────────────────────────────────────────────────────────────
+// A fragment shader is HEAD_COUNT or HEAD_SHOW, then OUTPUT, then a kernel
+// that ends in emit(i, z); OUTPUT decides what that writes.
 static const char* VS = R"(#version 410 core
 layout(location=0) in vec2 p; out vec2 uv;
 void main(){ uv=p*0.5+0.5; gl_Position=vec4(p,0,1);} )";
 
-static const char* FS = R"(#version 410 core
-in vec2 uv; out vec4 frag;
+static const char* HEAD_COUNT = "#version 410 core\n#define SHOW 0\n";
+static const char* HEAD_SHOW = "#version 410 core\n#define SHOW 1\n";
+
+// count: the raw iteration count into the R16UI fitness buffer
+// show:  its palette colour; with uSmooth the escape radius adds the
+//        continuous part, i + 1 - log2(log2|z|), so bands blend
+static const char* OUTPUT = R"(
+uniform int uMaxIter;
+#if SHOW
+out vec4 frag;
+uniform sampler1D uPalette;
+uniform bool uSmooth;
+#else
+out uint count;
+#endif
+
+void emit(int i, vec2 z){
+#if SHOW
+    float n = float(i);
+    if(uSmooth && i < uMaxIter) n = clamp(n + 1.0 - log2(0.5*log2(dot(z,z))), 0.0, float(uMaxIter));
+    float N = float(textureSize(uPalette, 0));   // entry k holds t = k/(N-1)
+    frag = texture(uPalette, (n/float(uMaxIter)*(N-1.0) + 0.5)/N);
+#else
+    count = uint(i);
+#endif
+}
+)";
+
+static const char* FS = R"(
+in vec2 uv;
 uniform vec2  uCenter;
 uniform float uZoom;
 uniform vec2  uRes;
-uniform int   uMaxIter;
+uniform bool  uInterior;
+
+// main cardioid / period-2 bulb, both inset so no escaping point is caught
+bool inBulbs(vec2 c){
+    float xq = c.x-0.25, y2 = c.y*c.y, q = xq*xq + y2;
+    if(q*(q+xq) < 0.25*y2 - 1e-5) return true;
+    float xb = c.x+1.0;
+    return xb*xb + y2 < 0.0615;
+}
 
 void main(){
     vec2 c;
     c.x = (uv.x-0.5)*uZoom*(uRes.x/uRes.y)+uCenter.x;
     c.y = (uv.y-0.5)*uZoom+uCenter.y;
 
-    vec2 z = vec2(0.0);
-    int  i = 0;
-    for(; i<uMaxIter && dot(z,z)<4.0; ++i)
+    vec2 z = vec2(0.0), zs = z;   // zs: Brent checkpoint, moved at 2^k steps
+    int  i = 0, lap = 1, step = 0;
+    if(uInterior && inBulbs(c)) i = uMaxIter;
+    for(; i<uMaxIter && dot(z,z)<4.0; ++i){
         z = vec2(z.x*z.x - z.y*z.y, 2.0*z.x*z.y) + c;
+        if(uInterior){
+            if(z == zs){ i = uMaxIter; break; }     // exact cycle: never escapes
+            if(++step == lap){ step = 0; lap *= 2; zs = z; }
+        }
+    }
+    emit(i, z);
+} )";
+
+// perturbation variant: Z_n from the reference orbit, per-pixel delta d,
+// rebase to the orbit start when |z| < |d| or the orbit runs out
+static const char* FS_DEEP = R"(
+in vec2 uv;
+uniform samplerBuffer uOrbit;
+uniform int   uOrbitLen;
+uniform vec2  uScale;       // zoom*(aspect,1)
 
-    float t  = float(i)/uMaxIter;
-    frag = vec4(t, t*t, sqrt(t), 1);
+void main(){
+    vec2 dc = (uv-0.5)*uScale;
+    vec2 d  = vec2(0.0), z = d;
+    int  m = 0, i = 0;
+    for(; i<uMaxIter; ++i){
+        vec2 Z = texelFetch(uOrbit, m).xy;
+        z = Z + d;
+        float r2 = dot(z,z);
+        if(r2 >= 4.0) break;
+        if(r2 < dot(d,d) || m == uOrbitLen-1){ d = z; m = 0; Z = vec2(0.0); }
+        vec2 t = 2.0*Z + d;
+        d = vec2(t.x*d.x - t.y*d.y, t.x*d.y + t.y*d.x) + dc;
+        ++m;
+    }
+    emit(i, z);
 } )";
 
+// counts of a CPU render through the same palette (no escape radius: banded)
+static const char* FS_IMAGE = R"(
+in vec2 uv;
+uniform usampler2D uImage;
+
+void main(){ emit(int(texture(uImage, uv).r), vec2(0.0)); } )";
+
+// ─── palette ─────────────────────────────────────────────────────────────────
+// the colour ramp (t, t², √t) of t = count/maxIter, tabulated once and read
+// with linear filtering instead of evaluated per pixel
+static constexpr int PALETTE_SIZE = 1024;
+
+static std::vector<unsigned char> makePalette(int n) {
+    std::vector<unsigned char> rgba(4 * n);
+    for (int k = 0; k < n; ++k) {
+        const float t = float(k) / (n - 1), c[3] = { t, t * t, std::sqrt(t) };
+        for (int j = 0; j < 3; ++j) rgba[4 * k + j] = (unsigned char)(c[j] * 255.0f + 0.5f);
+        rgba[4 * k + 3] = 255;
+    }
+    return rgba;
+}
+
 // ─── helper helpers ──────────────────────────────────────────────────────────
-static GLuint compile(GLenum tp, const char* src) {
+static GLuint compile(GLenum tp, std::initializer_list<const char*> src) {
     GLuint s = glCreateShader(tp);
-    glShaderSource(s, 1, &src, nullptr);
+    glShaderSource(s, (GLsizei)src.size(), src.begin(), nullptr);
     glCompileShader(s);
     GLint ok; glGetShaderiv(s, GL_COMPILE_STATUS, &ok);
     if (!ok) {
@@ -52,24 +144,57 @@ static GLuint link(GLuint vs, GLuint fs) {
 }
 
 // ─── ctor/dtor ───────────────────────────────────────────────────────────────
-MandelbrotRenderer::MandelbrotRenderer(int winW, int winH) {
-    initShader(); initQuad(); initFBO();
-    glUseProgram(prog);
-    glUniform2f(uRes, (float)winW, (float)winH);
+MandelbrotRenderer::MandelbrotRenderer(int winW, int winH)
+    : aspect((float)winW / (float)winH) {
+    initShader(); initQuad(); initFBO(); initPalette();
+    for (const Kernel* k : { &kCount, &kShow }) {
+        glUseProgram(k->prog);
+        glUniform2f(k->uRes, (float)winW, (float)winH);
+    }
+    renderOffscreen();   // warm-up: lazy shader compile stays out of the first timing
 }
 MandelbrotRenderer::~MandelbrotRenderer() {
-    glDeleteProgram(prog); glDeleteVertexArrays(1, &vao);
+    freeRing(); glDeleteQueries(1, &timerQuery);
+    for (const Kernel* k : { &kCount, &kShow, &kDeepCount, &kDeepShow, &kImage })
+        glDeleteProgram(k->prog);
+    glDeleteTextures(1, &imageTex); glDeleteTextures(1, &paletteTex);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &orbitBuf); glDeleteTextures(1, &orbitTex);
     glDeleteBuffers(1, &vbo); glDeleteFramebuffers(1, &fbo);
     glDeleteTextures(1, &tex); glDeleteRenderbuffers(1, &rbo);
 }
 
 // ─── init helpers ────────────────────────────────────────────────────────────
 void MandelbrotRenderer::initShader() {
-    prog = link(compile(GL_VERTEX_SHADER, VS), compile(GL_FRAGMENT_SHADER, FS));
-    uCenter = glGetUniformLocation(prog, "uCenter");
-    uZoom = glGetUniformLocation(prog, "uZoom");
-    uRes = glGetUniformLocation(prog, "uRes");
-    uMaxIter = glGetUniformLocation(prog, "uMaxIter");
+    auto make = [](const char* head, const char* kernel) {
+        Kernel k;
+        k.prog = link(compile(GL_VERTEX_SHADER, { VS }),
+            compile(GL_FRAGMENT_SHADER, { head, OUTPUT, kernel }));
+        auto loc = [&k](const char* name) { return glGetUniformLocation(k.prog, name); };
+        k.uCenter = loc("uCenter"); k.uZoom = loc("uZoom"); k.uRes = loc("uRes");
+        k.uMaxIter = loc("uMaxIter"); k.uInterior = loc("uInterior");
+        k.uScale = loc("uScale"); k.uOrbit = loc("uOrbit"); k.uOrbitLen = loc("uOrbitLen");
+        k.uPalette = loc("uPalette"); k.uSmooth = loc("uSmooth"); k.uImage = loc("uImage");
+        glUseProgram(k.prog);                    // fixed units: 0 orbit/image, 1 palette
+        glUniform1i(k.uOrbit, 0);
+        glUniform1i(k.uImage, 0);
+        glUniform1i(k.uPalette, 1);
+        return k;
+    };
+    kCount = make(HEAD_COUNT, FS);
+    kShow = make(HEAD_SHOW, FS);
+    kDeepCount = make(HEAD_COUNT, FS_DEEP);
+    kDeepShow = make(HEAD_SHOW, FS_DEEP);
+    kImage = make(HEAD_SHOW, FS_IMAGE);
+    glGenBuffers(1, &orbitBuf);
+    glGenTextures(1, &orbitTex);
+
+    glGenTextures(1, &imageTex);
+    glBindTexture(GL_TEXTURE_2D, imageTex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 }
 void MandelbrotRenderer::initQuad() {
     float tri[6] = { -1,-1, 3,-1, -1,3 };
@@ -82,30 +207,79 @@ void MandelbrotRenderer::initQuad() {
 void MandelbrotRenderer::initFBO() {
     glGenFramebuffers(1, &fbo); glBindFramebuffer(GL_FRAMEBUFFER, fbo);
     glGenTextures(1, &tex); glBindTexture(GL_TEXTURE_2D, tex);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, OFF_W, OFF_H, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R16UI, offW, offH, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
     glGenRenderbuffers(1, &rbo); glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, OFF_W, OFF_H);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, offW, offH);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         std::cerr << "FBO incomplete!\n";
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
     glGenQueries(1, &timerQuery);
-    pixels.resize(OFF_W * OFF_H);
+    counts.resize(offW * offH);
+}
+void MandelbrotRenderer::initPalette() {
+    const std::vector<unsigned char> rgba = makePalette(PALETTE_SIZE);
+    glGenTextures(1, &paletteTex);
+    glBindTexture(GL_TEXTURE_1D, paletteTex);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA8, PALETTE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+}
+void MandelbrotRenderer::setResolution(int w, int h) {
+    if (w == offW && h == offH) return;
+    offW = w; offH = h;                          // same objects, new storage
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R16UI, offW, offH, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, nullptr);
+    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, offW, offH);
 }
 
 // ─── per‑frame interface ─────────────────────────────────────────────────────
+// view, maxIter and the interior check are kept here and set on whichever
+// kernel draws next
 void MandelbrotRenderer::setView(float cx, float cy, float zoom) {
-    glUseProgram(prog);
-    glUniform2f(uCenter, cx, cy);
-    glUniform1f(uZoom, zoom);
+    view.cx = dd(cx); view.cy = dd(cy); view.zoom = zoom;
+}
+void MandelbrotRenderer::setView(const DeepView& v) {
+    view = v;
 }
 void MandelbrotRenderer::setMaxIter(int it) {
-    glUseProgram(prog);
-    glUniform1i(uMaxIter, it);
+    maxIter = it < MAX_ITER ? it : MAX_ITER;
+}
+void MandelbrotRenderer::useProgram(bool show) {
+    const Kernel& k = deep ? (show ? kDeepShow : kDeepCount) : (show ? kShow : kCount);
+    glUseProgram(k.prog);
+    glUniform1i(k.uMaxIter, maxIter);
+    if (show) {
+        glUniform1i(k.uSmooth, smooth ? 1 : 0);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_1D, paletteTex);
+        glActiveTexture(GL_TEXTURE0);
+    }
+    if (!deep) {
+        glUniform2f(k.uCenter, float(double(view.cx)), float(double(view.cy)));
+        glUniform1f(k.uZoom, float(view.zoom));
+        glUniform1i(k.uInterior, interior ? 1 : 0);
+        return;
+    }
+
+    // the orbit is re-uploaded only when the centre moves or maxIter grows
+    if (orbit.update(view.cx, view.cy, maxIter)) {
+        std::vector<float> z(orbit.data(), orbit.data() + 2 * orbit.length());
+        glBindBuffer(GL_TEXTURE_BUFFER, orbitBuf);
+        glBufferData(GL_TEXTURE_BUFFER, z.size() * sizeof(float), z.data(), GL_STATIC_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, orbitTex);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, orbitBuf);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, orbitTex);
+    glUniform1i(k.uOrbitLen, orbit.length());
+    glUniform2f(k.uScale, float(view.zoom * aspect), float(view.zoom));
 }
 void MandelbrotRenderer::renderOnscreen() {
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -113,21 +287,123 @@ void MandelbrotRenderer::renderOnscreen() {
     glViewport(0, 0, w, h);
     glClear(GL_COLOR_BUFFER_BIT);
     glBindVertexArray(vao);
-    glUseProgram(prog);
+    useProgram(true);
     glDrawArrays(GL_TRIANGLES, 0, 3);
 }
-void MandelbrotRenderer::renderOffscreen() {
+void MandelbrotRenderer::renderOnscreen(const std::uint16_t* px, int w, int h, int it) {
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, imageTex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    if (w != imageW || h != imageH) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R16UI, w, h, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, px);
+        imageW = w; imageH = h;
+    }
+    else glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, GL_RED_INTEGER, GL_UNSIGNED_SHORT, px);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    int fw, fh; glfwGetFramebufferSize(glfwGetCurrentContext(), &fw, &fh);
+    glViewport(0, 0, fw, fh);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glBindVertexArray(vao);
+    glUseProgram(kImage.prog);
+    glUniform1i(kImage.uMaxIter, it < MAX_ITER ? it : MAX_ITER);
+    glUniform1i(kImage.uSmooth, 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_1D, paletteTex);
+    glActiveTexture(GL_TEXTURE0);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+void MandelbrotRenderer::drawOffscreen(GLuint query) {
     glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-    glViewport(0, 0, OFF_W, OFF_H);
+    glViewport(0, 0, offW, offH);
 
-    glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+    useProgram(false);                           // orbit upload stays outside the query
+    glBeginQuery(GL_TIME_ELAPSED, query);
     glBindVertexArray(vao);
     glDrawArrays(GL_TRIANGLES, 0, 3);
     glEndQuery(GL_TIME_ELAPSED);
+}
+void MandelbrotRenderer::renderOffscreen() {
+    {
+        ScopedStage st(stages, Stage::Render);
+        drawOffscreen(timerQuery);
 
-    GLuint timeNS = 0; glGetQueryObjectuiv(timerQuery, GL_QUERY_RESULT, &timeNS);
-    gpuTimeMs = timeNS * 1e-6f;
+        GLuint64 timeNS = 0; glGetQueryObjectui64v(timerQuery, GL_QUERY_RESULT, &timeNS);
+        gpuTimeMs = float(timeNS * 1e-6);        // 64-bit: no wrap past 4.29 s
+    }
 
-    glReadPixels(0, 0, OFF_W, OFF_H, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+    ScopedStage st(stages, Stage::Readback);
+    pixW = offW; pixH = offH;
+    counts.resize(pixW * pixH);
+    glPixelStorei(GL_PACK_ALIGNMENT, 2);
+    glReadPixels(0, 0, pixW, pixH, GL_RED_INTEGER, GL_UNSIGNED_SHORT, counts.data());
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
+
+// ─── pipelined evaluation ────────────────────────────────────────────────────
+void MandelbrotRenderer::setPipelineDepth(int depth) {
+    freeRing();
+    ring.resize(depth < 2 ? 2 : depth);
+    for (auto& s : ring) {
+        glGenQueries(1, &s.query);
+        glGenBuffers(1, &s.pbo);                 // storage sized on first use
+    }
+    head = inFlight = 0;
+}
+void MandelbrotRenderer::freeRing() {
+    int tag; while (drainOffscreen(tag)) {}
+    for (auto& s : ring) { glDeleteQueries(1, &s.query); glDeleteBuffers(1, &s.pbo); }
+    ring.clear();
+}
+bool MandelbrotRenderer::submitOffscreen(int tag, int& doneTag) {
+    if (ring.empty()) setPipelineDepth(2);
+    Slot& s = ring[head];                        // free: its last frame completed
+    {
+        ScopedStage st(stages, Stage::Render);  // queueing only; the wait is in readback
+        drawOffscreen(s.query);
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);   // async: returns before the copy
+        s.w = offW; s.h = offH;
+        const int bytes = s.w * s.h * (int)sizeof(std::uint16_t);
+        if (s.capacity < bytes) {
+            s.capacity = bytes;
+            glBufferData(GL_PIXEL_PACK_BUFFER, s.capacity, nullptr, GL_STREAM_READ);
+        }
+        glPixelStorei(GL_PACK_ALIGNMENT, 2);
+        glReadPixels(0, 0, s.w, s.h, GL_RED_INTEGER, GL_UNSIGNED_SHORT, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    s.tag = tag;
+    head = (head + 1) % (int)ring.size();
+    if (++inFlight < (int)ring.size()) return false;
+    completeOldest(doneTag);
+    return true;
+}
+bool MandelbrotRenderer::drainOffscreen(int& doneTag) {
+    if (inFlight == 0) return false;
+    completeOldest(doneTag);
+    return true;
+}
+void MandelbrotRenderer::completeOldest(int& doneTag) {
+    ScopedStage st(stages, Stage::Readback);
+    int n = (int)ring.size();
+    Slot& s = ring[(head - inFlight + n) % n];
+
+    GLuint64 timeNS = 0; glGetQueryObjectui64v(s.query, GL_QUERY_RESULT, &timeNS);
+    gpuTimeMs = float(timeNS * 1e-6);
+
+    pixW = s.w; pixH = s.h;
+    counts.resize(pixW * pixH);
+    const int bytes = pixW * pixH * (int)sizeof(std::uint16_t);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+    if (const void* src = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT)) {
+        std::memcpy(counts.data(), src, bytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    doneTag = s.tag;
+    --inFlight;
+}
@@ -1,35 +1,89 @@
 ﻿#pragma once
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <cstdint>
 #include <vector>
+#include "RenderBackend.h"
 
-class MandelbrotRenderer {
+// The fitness FBO is GL_R16UI: each kernel writes its raw count, read back
+// as 16-bit integers. On screen the same kernels map the count through a
+// palette texture, optionally smoothed by the escape radius (continuous
+// iteration count), so colour never limits what the metrics see.
+class MandelbrotRenderer : public RenderBackend {
 public:
     MandelbrotRenderer(int winW, int winH);
     ~MandelbrotRenderer();
 
-    void setView(float cx, float cy, float zoom);
-    void setMaxIter(int it);
+    void setView(float cx, float cy, float zoom) override;
+    void setView(const DeepView& v) override;
+    void setMaxIter(int it) override;
+    void setDeepZoom(bool on) override { deep = on; }   // float deltas: ~1e-30
+    void setInteriorCheck(bool on) override { interior = on; }
+    void setResolution(int w, int h) override;   // FBO size; frames in flight keep theirs
+    void setSmooth(bool on) { smooth = on; }     // onscreen: continuous count colouring
 
-    void renderOnscreen();   // draw best individual to screen
-    void renderOffscreen();  // draw to 256×256 FBO for fitness
+    void renderOnscreen();            // draw best individual to screen
+    // show the w×h counts of a CPU render (e.g. a progressive preview) instead
+    void renderOnscreen(const std::uint16_t* counts, int w, int h, int maxIter);
+    void renderOffscreen() override;  // draw to the w×h FBO for fitness
 
-    float  lastGpuTimeMs() const { return gpuTimeMs; }
-    float  fps()           const { return 1000.0f / gpuTimeMs; }
-    const unsigned char* pixelPtr() const { return pixels.data(); }
+    float  lastGpuTimeMs() const override { return gpuTimeMs; }
+    const std::uint16_t* iterationPtr() const override { return counts.data(); }
+    int    width() const override { return pixW; }
+    int    height() const override { return pixH; }
 
-    static constexpr int OFF_W = 256;
-    static constexpr int OFF_H = 256;
+    // Pipelined evaluation: a ring of `depth` timer queries + pixel-pack
+    // buffers. submitOffscreen() draws and queues an async readback tagged
+    // `tag`; once the ring is full it completes the oldest frame into
+    // iterationPtr()/lastGpuTimeMs() and returns true with its tag, so frame k
+    // comes back while frame k+depth-1 is drawn. drainOffscreen() empties it.
+    void setPipelineDepth(int depth);            // ≥ 2; drains in-flight frames
+    int  pipelineDepth() const { return (int)ring.size(); }
+    bool submitOffscreen(int tag, int& doneTag);
+    bool drainOffscreen(int& doneTag);
 
 private:
-    GLuint prog, vao, vbo;
+    struct Slot { GLuint query = 0, pbo = 0; int tag = -1, w = 0, h = 0, capacity = 0; };
+    // one linked program and its uniforms (-1: not used by it)
+    struct Kernel {
+        GLuint prog = 0;
+        GLint  uCenter, uZoom, uRes, uMaxIter, uInterior;
+        GLint  uScale, uOrbit, uOrbitLen;        // deep
+        GLint  uPalette, uSmooth, uImage;        // colour output
+    };
+
+    // float and deep (perturbation: reference orbit in a texture buffer,
+    // deltas in the shader) kernels, each writing counts or colours
+    Kernel kCount, kShow, kDeepCount, kDeepShow;
+    Kernel kImage;                               // CPU counts → palette
+    GLuint vao, vbo;
     GLuint fbo, tex, rbo, timerQuery;
-    GLint  uCenter, uZoom, uRes, uMaxIter;
+    GLuint orbitBuf, orbitTex, paletteTex;
+    bool   deep = false, interior = false, smooth = true;
+
+    // CPU counts shown by renderOnscreen(counts, w, h, maxIter)
+    GLuint imageTex;
+    int    imageW = 0, imageH = 0;
+    float  aspect;
+    int    maxIter = 0;
+    DeepView view;
+    ReferenceOrbit orbit;
 
+    int   offW = OFF_W, offH = OFF_H;            // FBO size
+    int   pixW = OFF_W, pixH = OFF_H;            // size of the frame in pixels
     float gpuTimeMs = 0.0f;
-    std::vector<unsigned char> pixels;
+    std::vector<std::uint16_t> counts;
+
+    std::vector<Slot> ring;
+    int head = 0, inFlight = 0;
 
     void initShader();
     void initQuad();
     void initFBO();
+    void initPalette();
+    // count or colour kernel for the current mode, uniforms set, ready to draw
+    void useProgram(bool show);
+    void drawOffscreen(GLuint query);
+    void completeOldest(int& doneTag);
+    void freeRing();
 };
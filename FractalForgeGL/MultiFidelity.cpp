@@ -0,0 +1,140 @@
+﻿#include "MultiFidelity.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+// ─── rank correlation ────────────────────────────────────────────────────────
+static std::vector<double> averageRanks(const std::vector<float>& v)
+{
+    const int n = (int)v.size();
+    std::vector<int> idx(n);
+    std::iota(idx.begin(), idx.end(), 0);
+    std::sort(idx.begin(), idx.end(), [&v](int a, int b) { return v[a] < v[b]; });
+    std::vector<double> r(n);
+    for (int i = 0; i < n;) {
+        int j = i;
+        while (j + 1 < n && v[idx[j + 1]] == v[idx[i]]) ++j;
+        for (int k = i; k <= j; ++k) r[idx[k]] = 0.5 * (i + j);
+        i = j + 1;
+    }
+    return r;
+}
+
+float spearman(const std::vector<float>& x, const std::vector<float>& y)
+{
+    const int n = (int)x.size();
+    if (n < 3) return NAN;
+    std::vector<double> rx = averageRanks(x), ry = averageRanks(y);
+    double mx = 0, my = 0;
+    for (int i = 0; i < n; ++i) { mx += rx[i]; my += ry[i]; }
+    mx /= n; my /= n;
+    double sxy = 0, sxx = 0, syy = 0;
+    for (int i = 0; i < n; ++i) {
+        sxy += (rx[i] - mx) * (ry[i] - my);
+        sxx += (rx[i] - mx) * (rx[i] - mx);
+        syy += (ry[i] - my) * (ry[i] - my);
+    }
+    return (sxx > 0 && syy > 0) ? float(sxy / std::sqrt(sxx * syy)) : NAN;
+}
+
+// fpsErr, gpuMs, boundary, density by index
+static float measuredValue(const Fitness& f, int m)
+{
+    return m == 0 ? f.fpsErr : m == 1 ? f.gpuMs : m == 2 ? f.boundary : f.density;
+}
+
+// ─── proxy → full genome ─────────────────────────────────────────────────────
+Fitness MultiFidelity::extrapolate(const Fitness& f, const Genome& proxy, const Genome& full) const
+{
+    if (proxy == full) return f;
+    const double side = double(full.side()) / proxy.side();
+    Fitness e = f;
+    e.gpuMs = float(f.gpuMs * side * side);
+    e.fpsErr = std::abs(1000.0f / e.gpuMs - targetFPS);
+    e.boundary = float(f.boundary * double(full.res) / proxy.res);
+    return e;
+}
+
+// the best keep·|active| by front, then crowding, as NSGAII::select() would
+std::vector<int> MultiFidelity::promote(const std::vector<int>& active, const std::vector<Fitness>& est)
+{
+    const int n = (int)active.size();
+    std::vector<float> keys(n * NOBJ), crowd(n);
+    std::vector<int> rank(n);
+    for (int i = 0; i < n; ++i) {
+        const Fitness& f = est[active[i]];
+        Individual ind;
+        ind.obj[0] = f.fpsErr;
+        ind.obj[1] = f.gpuMs;
+        ind.obj[2] = -f.boundary;
+        ind.obj[3] = -f.density;
+        NSGAII::objectiveKey(ind, &keys[i * NOBJ]);
+    }
+    const int fronts = sorter.sort(keys.data(), n, rank.data());
+    sorter.crowding(keys.data(), rank.data(), n, fronts, crowd.data());
+
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        if (rank[a] != rank[b]) return rank[a] < rank[b];
+        return crowd[a] > crowd[b];
+        });
+    const int m = std::max(1, (int)std::ceil(keep * n));
+    std::vector<int> out(m);
+    for (int i = 0; i < m; ++i) out[i] = active[order[i]];
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+// ─── successive halving ──────────────────────────────────────────────────────
+void MultiFidelity::run(const std::vector<EvalJob>& jobs, const RenderFn& render,
+    std::vector<char>& kept, std::vector<Fitness>& out)
+{
+    const int n = (int)jobs.size();
+    std::vector<int> active(n);
+    std::iota(active.begin(), active.end(), 0);
+    std::vector<Fitness> est(n), prev(n), fit;
+    std::vector<EvalJob> batch;
+    last.clear();
+
+    // a level's correlation is known once the promoted jobs are re-rendered
+    std::vector<float> a, b;
+    auto correlate = [&](FidelityStats& s) {
+        a.resize(active.size());
+        b.resize(active.size());
+        for (int m = 0; m < 4; ++m) {
+            for (size_t i = 0; i < active.size(); ++i) {
+                a[i] = measuredValue(prev[active[i]], m);
+                b[i] = measuredValue(est[active[i]], m);
+            }
+            s.spearman[m] = spearman(a, b);
+        }
+    };
+
+    for (size_t L = 0; L <= levels.size(); ++L) {
+        const bool full = L == levels.size();
+        batch.clear();
+        for (int k : active) {
+            Genome g = jobs[k].g;
+            if (!full && g.side() > levels[L]) { g.res = std::min(g.res, levels[L]); g.supersample = 1; }
+            batch.push_back({ jobs[k].idx, g });
+        }
+        render(batch, fit);
+        for (size_t i = 0; i < active.size(); ++i)
+            est[active[i]] = extrapolate(fit[i], batch[i].g, jobs[active[i]].g);
+
+        if (L > 0) correlate(last.back());
+        FidelityStats s;
+        s.res = full ? 0 : levels[L];
+        if (full) std::fill(s.spearman, s.spearman + 4, NAN);   // nothing above it
+        s.evaluated = (int)active.size();
+        if (!full) active = promote(active, est);
+        s.promoted = (int)active.size();
+        last.push_back(s);
+        prev = est;
+    }
+
+    kept.assign(n, 0);
+    out.assign(n, Fitness());
+    for (int k : active) { kept[k] = 1; out[k] = est[k]; }
+}
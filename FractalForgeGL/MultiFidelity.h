@@ -0,0 +1,45 @@
+﻿#pragma once
+#include <functional>
+#include <vector>
+#include "FitnessMetrics.h"
+#include "NSGAII.h"
+
+// ─── successive-halving evaluation over fitness-buffer resolutions ───────────
+// Every job is first rendered at the lowest level (res capped at the level,
+// no supersampling), its objectives extrapolated to the genome's own buffer
+// (time × pixel ratio, edges × side ratio, variance as is). The best `keep`
+// fraction by front and crowding goes up a level, and so on; only what
+// survives the last level is rendered as the genome asks. A genome whose own
+// buffer is no larger than a level is exact there (and the cache sees it so).
+struct FidelityStats {
+    int   res = 0;                               // level side; 0 = the genome's own
+    int   evaluated = 0, promoted = 0;
+    float spearman[4] = {};                      // vs. the next level, promoted jobs only
+};
+
+class MultiFidelity {
+public:
+    using RenderFn = std::function<void(const std::vector<EvalJob>&, std::vector<Fitness>&)>;
+
+    MultiFidelity(std::vector<int> levels, float keep, float targetFPS)
+        : levels(std::move(levels)), keep(keep), targetFPS(targetFPS) {}
+
+    // kept[k] = 1 for jobs that reached the full render, out[k] their fitness
+    void run(const std::vector<EvalJob>& jobs, const RenderFn& render,
+        std::vector<char>& kept, std::vector<Fitness>& out);
+
+    // per level of the last run(), the full render last
+    const std::vector<FidelityStats>& stats() const { return last; }
+
+private:
+    std::vector<int> levels;
+    float keep, targetFPS;
+    std::vector<FidelityStats> last;
+    NonDominatedSort sorter;
+
+    Fitness extrapolate(const Fitness& f, const Genome& proxy, const Genome& full) const;
+    std::vector<int> promote(const std::vector<int>& active, const std::vector<Fitness>& est);
+};
+
+// rank correlation of x and y (average ranks for ties); NaN below 3 pairs
+float spearman(const std::vector<float>& x, const std::vector<float>& y);
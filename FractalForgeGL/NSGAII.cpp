@@ -1,130 +1,414 @@
 ﻿#include "NSGAII.h"
 #include <algorithm>
 #include <cmath>
+#include <numeric>
+#include <sstream>
 
-// ─── dominance test ──────────────────────────────────────────────────────────
-bool NSGAII::dominates(const Individual& a, const Individual& b)
+// ─── dominance key ───────────────────────────────────────────────────────────
+void NSGAII::objectiveKey(const Individual& ind, float* key)
 {
-    bool better = false;
-    for (int k = 0; k < 4; ++k) {
-        float av = a.obj[k], bv = b.obj[k];
-        if (k >= 2) { av = -av;  bv = -bv; }      // maximise -> minimise negative
+    for (int k = 0; k < NOBJ; ++k)
+        key[k] = (k >= 2) ? -ind.obj[k] : ind.obj[k];   // maximise -> minimise negative
+}
+
+// ─── ctor ────────────────────────────────────────────────────────────────────
+NSGAII::NSGAII(int population, const GenomeBounds& b, unsigned seed)
+    : popSize(population), bounds(b), pop(population), rng(seed),
+    model(b.minIter, b.maxIter, b.minRes, b.maxRes, b.maxSupersample)
+{
+    // integer genes get ±0.499 around their range so every value rounds
+    // from an equally wide interval
+    lo[0] = std::log2(float(b.minIter));         hi[0] = std::log2(float(b.maxIter));
+    lo[1] = std::log2(float(b.minRes)) - 0.499f; hi[1] = std::log2(float(b.maxRes)) + 0.499f;
+    lo[2] = 1 - 0.499f;                          hi[2] = b.maxSupersample + 0.499f;
+    lo[3] = -0.499f;                             hi[3] = 1.499f;
 
-        if (av > bv) return false;                // worse in at least one
-        if (av < bv) better = true;               // strictly better somewhere
+    for (auto& ind : pop) {
+        for (int j = 0; j < NGENE; ++j)
+            ind.x[j] = std::uniform_real_distribution<float>(lo[j], hi[j])(rng);
+        decode(ind);
     }
-    return better;
+    hasPred.assign(popSize, 0);
+    scrStats.rendered = popSize;
 }
 
-// ─── ctor ────────────────────────────────────────────────────────────────────
-NSGAII::NSGAII(int population, int mn, int mx)
-    : popSize(population), minIter(mn), maxIter(mx),
-    pop(population), offspring(population)
+void NSGAII::setScreening(const Screening& s)
+{
+    scr = s;
+    model = Surrogate(bounds.minIter, bounds.maxIter, bounds.minRes, bounds.maxRes,
+        bounds.maxSupersample, s.capacity);
+}
+
+void NSGAII::decode(Individual& ind) const
 {
-    std::uniform_int_distribution<int> dist(minIter, maxIter);
-    for (auto& ind : pop) ind.maxIter = dist(rng);
+    Genome& g = ind.g;
+    g.maxIter = clampVal((int)std::lround(std::exp2(ind.x[0])), bounds.minIter, bounds.maxIter);
+    g.res = clampVal(1 << clampVal((int)std::lround(ind.x[1]), 0, 16), bounds.minRes, bounds.maxRes);
+    g.supersample = clampVal((int)std::lround(ind.x[2]), 1,
+        std::max(1, std::min(bounds.maxSupersample, bounds.maxSide / g.res)));
+    g.interior = bounds.interior && std::lround(ind.x[3]) == 1;
 }
 
 // ─── getters / setters ───────────────────────────────────────────────────────
 Individual& NSGAII::current() { return pop[evalIndex]; }
 const Individual& NSGAII::best() const {
-    return *std::min_element(pop.begin(), pop.end(),
+    // no survivors (first generation, or a new view): only pop[0, evalIndex)
+    // has a fitness yet; pop[0] stands in until the first one is measured
+    const bool surv = !parents.empty();
+    const auto first = surv ? parents.begin() : pop.begin();
+    const auto last = surv ? parents.end() : pop.begin() + std::max(evalIndex, 1);
+    return *std::min_element(first, last,
         [](const Individual& a, const Individual& b) {
             return a.obj[0] < b.obj[0]; });
 }
+void NSGAII::resetObjectives()
+{
+    model.clear();
+    arch.clear();
+    if (!parents.empty()) {
+        // the old best first, so best() keeps showing it until pop[0] is redone
+        std::swap(parents[0], parents[&best() - parents.data()]);
+        pop.insert(pop.begin(), parents.begin(), parents.end());
+        parents.clear();
+    }
+    hasPred.assign(pop.size(), 0);               // predicted for the old view
+    predicted.resize(pop.size());
+    evalIndex = 0;
+}
 bool NSGAII::nextIndividual()
 {
     ++evalIndex;
-    if (evalIndex == popSize) { evalIndex = 0; return true; }
+    if (evalIndex == (int)pop.size()) { evalIndex = 0; return true; }
     return false;
 }
 void NSGAII::setFitness(float fpsErr, float gpuMs,
     float boundary, float density)
 {
-    pop[evalIndex].obj[0] = fpsErr;
-    pop[evalIndex].obj[1] = gpuMs;
-    pop[evalIndex].obj[2] = -boundary;
-    pop[evalIndex].obj[3] = -density;
+    setFitness(evalIndex, fpsErr, gpuMs, boundary, density);
 }
 
-// ─── ranking / crowding ──────────────────────────────────────────────────────
-void NSGAII::calcCrowding(std::vector<Individual*>& F)
+// ─── batch interface ─────────────────────────────────────────────────────────
+std::vector<EvalJob> NSGAII::jobs(int first, int count) const
 {
-    const int M = 4, s = (int)F.size();
-    for (auto* p : F) p->crowd = 0.0f;
-
-    for (int m = 0; m < M; ++m) {
-        std::sort(F.begin(), F.end(),
-            [m](Individual* a, Individual* b) { return a->obj[m] < b->obj[m]; });
+    const int n = (int)pop.size();
+    first = clampVal(first, 0, n);
+    int last = (count < 0) ? n : clampVal(first + count, first, n);
+    std::vector<EvalJob> out;
+    out.reserve(last - first);
+    for (int i = first; i < last; ++i) out.push_back({ i, pop[i].g });
+    return out;
+}
 
-        F.front()->crowd = F.back()->crowd = INFINITY;
-        float minv = F.front()->obj[m], maxv = F.back()->obj[m];
-        if (maxv - minv == 0) continue;
+void NSGAII::retain(const std::vector<char>& keep)
+{
+    int kept = 0;
+    for (int i = 0; i < (int)pop.size(); ++i) {
+        if (!keep[i]) continue;
+        pop[kept] = pop[i];
+        const bool pred = i < (int)hasPred.size() && hasPred[i];
+        if (pred) predicted[kept] = predicted[i];
+        if (kept < (int)hasPred.size()) hasPred[kept] = pred;
+        ++kept;
+    }
+    pop.resize(kept);
+    hasPred.resize(std::min(hasPred.size(), pop.size()));
+    evalIndex = 0;
+}
+void NSGAII::setFitness(int idx, float fpsErr, float gpuMs,
+    float boundary, float density)
+{
+    pop[idx].obj[0] = fpsErr;
+    pop[idx].obj[1] = gpuMs;
+    pop[idx].obj[2] = -boundary;
+    pop[idx].obj[3] = -density;
 
-        for (int i = 1; i < s - 1; ++i)
-            F[i]->crowd += (F[i + 1]->obj[m] - F[i - 1]->obj[m]) / (maxv - minv);
+    if (archiveOn) {
+        float key[NOBJ];
+        objectiveKey(pop[idx], key);
+        arch.insert(key, pop[idx]);
+    }
+    if (scr.on) {
+        float m[4];
+        measured(pop[idx], m);
+        model.add(pop[idx].g, m);
     }
 }
 
-void NSGAII::assignRanks()
+// the four values as measured, whatever the signs in obj
+void NSGAII::measured(const Individual& ind, float* m)
+{
+    m[0] = ind.obj[0]; m[1] = ind.obj[1]; m[2] = -ind.obj[2]; m[3] = -ind.obj[3];
+}
+bool NSGAII::prediction(int idx, float* m) const
 {
-    std::vector<std::vector<int>> fronts;
-    std::vector<int> dominated(popSize, 0);
-    std::vector<std::vector<int>> domList(popSize);
+    if (idx < 0 || idx >= (int)hasPred.size() || !hasPred[idx]) return false;
+    std::copy(predicted[idx].begin(), predicted[idx].end(), m);
+    return true;
+}
 
-    for (int p = 0; p < popSize; ++p)
-        for (int q = 0; q < popSize; ++q) if (p != q) {
-            if (dominates(pop[p], pop[q])) domList[p].push_back(q);
-            else if (dominates(pop[q], pop[p])) ++dominated[p];
-        }
+// ─── ranking / crowding ──────────────────────────────────────────────────────
+void NSGAII::assignRanks(std::vector<Individual>& v)
+{
+    const int n = (int)v.size();
+    keys.resize(n * NOBJ);
+    ranks.resize(n);
+    crowds.resize(n);
+    for (int i = 0; i < n; ++i) objectiveKey(v[i], &keys[i * NOBJ]);
 
-    for (int i = 0; i < popSize; ++i) if (!dominated[i]) {
-        pop[i].rank = 0;
-        if (fronts.empty()) fronts.emplace_back();
-        fronts[0].push_back(i);
-    }
+    int fronts = sorter.sort(keys.data(), n, ranks.data());
+    sorter.crowding(keys.data(), ranks.data(), n, fronts, crowds.data());
+    for (int i = 0; i < n; ++i) { v[i].rank = ranks[i]; v[i].crowd = crowds[i]; }
+}
 
-    int i = 0;
-    while (i < (int)fronts.size()) {
-        std::vector<int> next;
-        for (int p : fronts[i])
-            for (int q : domList[p])
-                if (--dominated[q] == 0) {
-                    pop[q].rank = i + 1;
-                    next.push_back(q);
-                }
-        if (!next.empty()) fronts.push_back(std::move(next));
-        ++i;
+// ─── survivor selection ──────────────────────────────────────────────────────
+void NSGAII::select()
+{
+    // how far off the predictions for this generation were
+    std::fill(scrStats.relErr, scrStats.relErr + 4, 0.0f);
+    scrStats.predicted = 0;
+    for (int i = 0; i < (int)pop.size(); ++i) {
+        if (!hasPred[i]) continue;
+        float m[4];
+        measured(pop[i], m);
+        for (int k = 0; k < 4; ++k)
+            scrStats.relErr[k] += std::abs(predicted[i][k] - m[k]) / std::max(std::abs(m[k]), 1e-6f);
+        ++scrStats.predicted;
     }
-    for (auto& f : fronts) {
-        std::vector<Individual*> ptrs;
-        for (int idx : f) ptrs.push_back(&pop[idx]);
-        calcCrowding(ptrs);
+    if (scrStats.predicted)
+        for (float& e : scrStats.relErr) e /= scrStats.predicted;
+    if (!parents.empty()) {                      // bred children, now evaluated
+        scrStats.renderedTotal += scrStats.rendered;
+        scrStats.skippedTotal += scrStats.skipped;
     }
+
+    merged.clear();                              // first generation: pop alone
+    merged.insert(merged.end(), parents.begin(), parents.end());
+    merged.insert(merged.end(), pop.begin(), pop.end());
+    assignRanks(merged);
+
+    // whole fronts while they fit, then the least crowded of the next one
+    order.resize(merged.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+        if (merged[a].rank != merged[b].rank) return merged[a].rank < merged[b].rank;
+        return merged[a].crowd > merged[b].crowd;
+        });
+    const int keep = std::min(popSize, (int)merged.size());
+    parents.resize(keep);
+    for (int i = 0; i < keep; ++i) parents[i] = merged[order[i]];
 }
-void NSGAII::recalcRanks() { assignRanks(); }
 
 // ─── selection & variation ───────────────────────────────────────────────────
-Individual NSGAII::tournament()
+const Individual& NSGAII::tournament()
 {
-    std::uniform_int_distribution<int> pick(0, popSize - 1);
-    Individual& A = pop[pick(rng)], & B = pop[pick(rng)];
+    std::uniform_int_distribution<int> pick(0, (int)parents.size() - 1);
+    const Individual& A = parents[pick(rng)], & B = parents[pick(rng)];
     if (A.rank < B.rank) return A;
     if (B.rank < A.rank) return B;
     return (A.crowd > B.crowd) ? A : B;
 }
 
-void NSGAII::evolve()
+// simulated binary crossover, bounded form: each gene with probability ½,
+// children spread around the parents with distribution index etaC
+void NSGAII::crossover(Individual& a, Individual& b)
+{
+    std::uniform_real_distribution<float> u(0, 1);
+    const float e = 1.0f / (var.etaC + 1.0f);
+    for (int j = 0; j < NGENE; ++j) {
+        if (u(rng) > 0.5f || std::abs(a.x[j] - b.x[j]) < 1e-6f) continue;
+        const float y1 = std::min(a.x[j], b.x[j]), y2 = std::max(a.x[j], b.x[j]);
+        const float r = u(rng);
+        auto betaq = [&](float beta) {
+            const float alpha = 2.0f - std::pow(beta, -(var.etaC + 1.0f));
+            return (r <= 1.0f / alpha) ? std::pow(r * alpha, e)
+                : std::pow(1.0f / (2.0f - r * alpha), e);
+        };
+        float c1 = 0.5f * (y1 + y2 - betaq(1.0f + 2.0f * (y1 - lo[j]) / (y2 - y1)) * (y2 - y1));
+        float c2 = 0.5f * (y1 + y2 + betaq(1.0f + 2.0f * (hi[j] - y2) / (y2 - y1)) * (y2 - y1));
+        c1 = clampVal(c1, lo[j], hi[j]); c2 = clampVal(c2, lo[j], hi[j]);
+        if (u(rng) < 0.5f) std::swap(c1, c2);
+        a.x[j] = c1; b.x[j] = c2;
+    }
+}
+
+// polynomial mutation, bounded form: each gene with probability mutProb
+void NSGAII::mutate(Individual& ind)
+{
+    std::uniform_real_distribution<float> u(0, 1);
+    const float e = 1.0f / (var.etaM + 1.0f);
+    for (int j = 0; j < NGENE; ++j) {
+        const float y = ind.x[j], span = hi[j] - lo[j];
+        if (u(rng) >= var.mutProb || span <= 0) continue;
+        const float d1 = (y - lo[j]) / span, d2 = (hi[j] - y) / span, r = u(rng);
+        float dq;
+        if (r < 0.5f)
+            dq = std::pow(2 * r + (1 - 2 * r) * std::pow(1 - d1, var.etaM + 1), e) - 1;
+        else
+            dq = 1 - std::pow(2 * (1 - r) + 2 * (r - 0.5f) * std::pow(1 - d2, var.etaM + 1), e);
+        ind.x[j] = clampVal(y + dq * span, lo[j], hi[j]);
+    }
+}
+
+void NSGAII::breed()
 {
-    assignRanks();
     std::uniform_real_distribution<float> pb(0, 1);
-    std::uniform_int_distribution<int>    delta(-128, 128);
+    pop.resize(popSize);
+    for (int i = 0; i < popSize; i += 2) {
+        Individual a = tournament(), b = tournament();
+        if (pb(rng) < var.crossProb) crossover(a, b);
+        mutate(a); mutate(b);
+        for (Individual* c : { &a, &b }) {
+            decode(*c);
+            std::fill(c->obj, c->obj + 4, 0.0f);
+            c->rank = 0; c->crowd = 0.0f;
+        }
+        pop[i] = std::move(a);
+        if (i + 1 < popSize) pop[i + 1] = std::move(b);
+    }
+    screen();
+    evalIndex = 0;
+}
+
+// ─── surrogate pre-screening ─────────────────────────────────────────────────
+// The coming select() is rehearsed on predictions: each child enters as its
+// optimistic prediction (each objective at the better end of mean ± κσ) next
+// to the survivors' measured objectives, and is rendered if it would make the
+// cut; the others are rendered with probability `explore`, so the model keeps
+// seeing the regions it rules out. Skipped children are dropped from pop.
+void NSGAII::screen()
+{
+    const int n = (int)pop.size();
+    skippedPop.clear();
+    hasPred.assign(n, 0);
+    predicted.resize(n);
+    scrStats.trained = model.size();
+    if (!scr.on || model.size() < scr.minTrain) {
+        scrStats.rendered = n; scrStats.skipped = 0;
+        return;
+    }
+    model.fit();
+
+    auto withMeasured = [](Individual ind, const float* m) {
+        ind.obj[0] = m[0]; ind.obj[1] = m[1]; ind.obj[2] = -m[2]; ind.obj[3] = -m[3];
+        return ind;
+    };
+    const int np = (int)parents.size(), m = np + n;
+    std::vector<SurrogatePrediction> pred(n);
+    keys.resize(m * NOBJ);
+    for (int i = 0; i < np; ++i) objectiveKey(parents[i], &keys[i * NOBJ]);
+    for (int i = 0; i < n; ++i) {
+        pred[i] = model.predict(pop[i].g, scr.kappa);
+        float lo[NOBJ], hi[NOBJ], * opt = &keys[(np + i) * NOBJ];
+        objectiveKey(withMeasured(pop[i], pred[i].lower), lo);
+        objectiveKey(withMeasured(pop[i], pred[i].upper), hi);
+        for (int k = 0; k < NOBJ; ++k) opt[k] = std::min(lo[k], hi[k]);
+    }
+    ranks.resize(m);
+    crowds.resize(m);
+    const int fronts = sorter.sort(keys.data(), m, ranks.data());
+    sorter.crowding(keys.data(), ranks.data(), m, fronts, crowds.data());
+    order.resize(m);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+        if (ranks[a] != ranks[b]) return ranks[a] < ranks[b];
+        return crowds[a] > crowds[b];
+        });
+    std::vector<char> survives(n, 0);
+    for (int i = 0; i < std::min(popSize, m); ++i)
+        if (order[i] >= np) survives[order[i] - np] = 1;
+
+    std::uniform_real_distribution<float> u(0, 1);
+    int kept = 0;
+    for (int i = 0; i < n; ++i) {
+        if (!survives[i] && u(rng) >= scr.explore) {
+            skippedPop.push_back(withMeasured(pop[i], pred[i].mean));
+            continue;
+        }
+        std::copy(pred[i].mean, pred[i].mean + 4, predicted[kept].begin());
+        hasPred[kept] = 1;
+        pop[kept++] = pop[i];
+    }
+    if (kept == 0) {                             // always render someone
+        std::uniform_int_distribution<int> pick(0, (int)skippedPop.size() - 1);
+        const int s = pick(rng);
+        Individual ind = skippedPop[s];
+        measured(ind, predicted[0].data());
+        hasPred[0] = 1;
+        std::fill(ind.obj, ind.obj + 4, 0.0f);
+        pop[kept++] = ind;
+        skippedPop.erase(skippedPop.begin() + s);
+    }
+    pop.resize(kept);
+    hasPred.resize(kept);
+    predicted.resize(kept);
+
+    scrStats.rendered = kept;
+    scrStats.skipped = (int)skippedPop.size();
+}
+
+// ─── snapshot ────────────────────────────────────────────────────────────────
+void NSGAII::save(ByteWriter& out) const
+{
+    out.put(std::uint32_t(sizeof(Individual)));
+    out.put(popSize);
+    out.put(bounds.minIter); out.put(bounds.maxIter);
+    out.put(bounds.minRes); out.put(bounds.maxRes);
+    out.put(bounds.maxSupersample); out.put(bounds.maxSide); out.put(bounds.interior);
+    out.put(var); out.put(scr);
+    out.put(evalIndex);
+    out.putVec(pop);
+    out.putVec(parents);
+    std::ostringstream engine;                   // the standard's portable text form
+    engine << rng;
+    out.putStr(engine.str());
+
+    out.put(archiveOn);
+    out.putVec(arch.members());
+    out.put(scrStats);
+    out.putVec(skippedPop);
+    out.putVec(predicted);
+    out.putVec(hasPred);
+    model.save(out);
+}
+
+bool NSGAII::load(ByteReader& in)
+{
+    std::uint32_t indSize = 0;
+    int n = 0;
+    GenomeBounds b;
+    in.get(indSize);
+    in.get(n);
+    in.get(b.minIter); in.get(b.maxIter);
+    in.get(b.minRes); in.get(b.maxRes);
+    in.get(b.maxSupersample); in.get(b.maxSide); in.get(b.interior);
+    if (indSize != sizeof(Individual) || n != popSize
+        || b.minIter != bounds.minIter || b.maxIter != bounds.maxIter
+        || b.minRes != bounds.minRes || b.maxRes != bounds.maxRes
+        || b.maxSupersample != bounds.maxSupersample || b.maxSide != bounds.maxSide
+        || b.interior != bounds.interior) return false;
+
+    in.get(var); in.get(scr);
+    in.get(evalIndex);
+    in.getVec(pop);
+    in.getVec(parents);
+    std::string engine;
+    in.getStr(engine);
+    std::istringstream is(engine);
+    if (!(is >> rng)) in.fail();
 
-    for (int i = 0; i < popSize; ++i) {
-        Individual child = tournament();
-        if (pb(rng) < 0.8f)
-            child.maxIter = clampVal(child.maxIter + delta(rng), minIter, maxIter);
-        offspring[i] = std::move(child);
+    std::vector<Individual> members;
+    in.get(archiveOn);
+    in.getVec(members);
+    arch.clear();
+    for (const Individual& ind : members) {      // all non-dominated: order kept
+        float key[NOBJ];
+        objectiveKey(ind, key);
+        arch.insert(key, ind);
     }
-    pop.swap(offspring);
+    in.get(scrStats);
+    in.getVec(skippedPop);
+    in.getVec(predicted);
+    in.getVec(hasPred);
+    model.load(in);
+    return in.ok() && evalIndex >= 0 && evalIndex <= (int)pop.size();
 }
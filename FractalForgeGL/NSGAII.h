@@ -1,45 +1,177 @@
 ﻿#pragma once
+#include <algorithm>
+#include <array>
 #include <vector>
 #include <random>
+#include "Snapshot.h"
+#include "ParetoSort.h"
+#include "RenderBackend.h"
+#include "Surrogate.h"
 
 // ─── genome + stats ───────────────────────────────────────────────────────────
+// Genes are real-coded for SBX / polynomial mutation and decoded into a
+// Genome: 0 log2 maxIter, 1 log2 res (rounded), 2 supersample (rounded),
+// 3 interior check (rounded to 0/1).
+constexpr int NGENE = 4;
+
+// search box of the genome
+struct GenomeBounds {
+    int  minIter = 128, maxIter = 20000;
+    int  minRes = 64, maxRes = 1024;             // powers of two in between
+    int  maxSupersample = 4;
+    int  maxSide = 1024;                         // res·supersample is capped here
+    bool interior = true;                        // false: the check is never on
+};
+
+// could decode() have produced g within b? (genomes from elsewhere)
+inline bool inBounds(const Genome& g, const GenomeBounds& b)
+{
+    return g.maxIter >= b.minIter && g.maxIter <= b.maxIter
+        && g.res >= b.minRes && g.res <= b.maxRes && !(g.res & (g.res - 1))
+        && g.supersample >= 1 && g.supersample <= b.maxSupersample
+        && g.side() <= std::max(b.maxSide, g.res) && (b.interior || !g.interior);
+}
+
+// variation operators (Deb's bounded SBX and polynomial mutation)
+struct Variation {
+    float crossProb = 0.9f;                      // per pair of children
+    float etaC = 15.0f;                          // SBX distribution index
+    float mutProb = 1.0f / NGENE;                // per gene
+    float etaM = 20.0f;                          // mutation distribution index
+};
+
+// surrogate pre-screening of bred children (see NSGAII::screen())
+struct Screening {
+    bool  on = false;
+    float explore = 0.1f;                        // unpromising children rendered anyway
+    float kappa = 1.0f;                          // children compete as mean − κσ
+    int   minTrain = 16;                         // distinct genomes before it is used
+    int   capacity = 192;                        // most recent distinct genomes kept
+};
+
+// screening of the generation being evaluated, plus run totals
+struct ScreenStats {
+    int   rendered = 0, skipped = 0;
+    int   predicted = 0;                         // rendered children that had a prediction
+    float relErr[4] = {};                        // mean |pred − actual| / actual, after select()
+    int   trained = 0;                           // distinct genomes behind the model
+    long long renderedTotal = 0, skippedTotal = 0;   // children of evaluated generations
+};
+
 struct Individual {
-    int   maxIter = 256;      // genome
-    float obj[4] = {};       // 0:FPSerr 1:GPUms 2:-boundary 3:-density
-    int   rank = 0;
-    float crowd = 0.0f;
+    float  x[NGENE] = {};    // genes
+    Genome g;                // decoded from x
+    float  obj[4] = {};      // 0:FPSerr 1:GPUms 2:-boundary 3:-density
+    int    rank = 0;
+    float  crowd = 0.0f;
+};
+
+// one independent evaluation: which slot of pop, and the genome to render
+struct EvalJob {
+    int idx;
+    Genome g;
 };
 
-// ─── minimalist NSGA‑II wrapper ──────────────────────────────────────────────
+// ─── (μ+λ) NSGA‑II ───────────────────────────────────────────────────────────
+// pop holds the λ = popSize individuals being evaluated; evolve() merges them
+// with the μ = popSize survivors of the last generation, keeps the best
+// popSize front by front (the last front cut by crowding distance) and breeds
+// the next pop from those by binary tournament, SBX and polynomial mutation.
+// Survivors are never rendered again, unless the view moves (resetObjectives).
 class NSGAII {
 public:
-    NSGAII(int population, int minIter, int maxIter);
+    NSGAII(int population, const GenomeBounds& bounds,
+        unsigned seed = std::random_device{}());
+
+    void setVariation(const Variation& v) { var = v; }
+    void setScreening(const Screening& s);
+    bool screening() const { return scr.on; }
+    // objectives changed (new view): the surrogate's training data, the
+    // archive's front and every fitness so far were measured under the old
+    // ones; the survivors rejoin pop and the generation is measured again
+    void resetObjectives();
 
     Individual& current();
     bool nextIndividual();                       // true when gen done
     void setFitness(float fpsErr, float gpuMs,
         float boundary, float density);
 
-    void evolve();                               // next generation
+    void evolve() { select(); breed(); }         // next generation
+    void select();                               // survivors of elite ∪ pop
+    void breed();                                // new pop from the survivors
+
+    // batch interface: the generation as independent jobs, results in any
+    // order (distinct idx may be set from different threads)
+    std::vector<EvalJob> jobs(int first = 0, int count = -1) const;
+    void setFitness(int idx, float fpsErr, float gpuMs,
+        float boundary, float density);
+    int  size() const { return (int)pop.size(); }   // ≤ popSize when screening
+    // drop pop[i] with keep[i] == 0 before it gets a fitness (turned down by a
+    // cheaper evaluation, e.g. MultiFidelity); order is kept, so jobs() after
+    // this lists the kept ones in their old relative order
+    void retain(const std::vector<char>& keep);
+
+    // rank key of an evaluated individual: NOBJ values, all minimised
+    static void objectiveKey(const Individual& ind, float* key);
 
     // for main.cpp
-    void recalcRanks();                          // recompute ranks only
     const std::vector<Individual>& population() const { return pop; }
-    const Individual& best() const;
+    const std::vector<Individual>& elite() const { return parents; }  // ranked by select()
+    const Individual& best() const;              // lowest FPS error among the survivors,
+                                                 // else among pop measured so far
+
+    // screening: predicted (fpsErr, gpuMs, boundary, density) of pop[idx];
+    // children that were not rendered, with predicted objectives
+    bool prediction(int idx, float* measured) const;
+    const std::vector<Individual>& skipped() const { return skippedPop; }
+    const ScreenStats& screenStats() const { return scrStats; }
+
+    // optional all-time non-dominated set, fed by setFitness() (which must
+    // then be called from one thread at a time, as with screening)
+    void enableArchive(bool on) { archiveOn = on; }
+    const ParetoArchive<Individual>& archive() const { return arch; }
+
+    // everything a run depends on: survivors, the pop being evaluated, rng
+    // and screening state; load() wants the same population size and bounds
+    void save(ByteWriter& out) const;
+    bool load(ByteReader& in);
 
 private:
-    int popSize, minIter, maxIter;
+    int popSize;
     int evalIndex = 0;
+    GenomeBounds bounds;
+    Variation var;
+    float lo[NGENE], hi[NGENE];                  // gene ranges
+
+    std::vector<Individual> pop;                 // λ, being evaluated
+    std::vector<Individual> parents;             // μ, evaluated survivors
+    std::vector<Individual> merged;
+    std::mt19937 rng;
+
+    // ranking state, flat and reused across generations
+    NonDominatedSort sorter;
+    std::vector<float> keys;                     // n·NOBJ, minimised
+    std::vector<int>   ranks, order;
+    std::vector<float> crowds;
+
+    bool archiveOn = false;
+    ParetoArchive<Individual> arch;
 
-    std::vector<Individual> pop;
-    std::vector<Individual> offspring;
-    std::mt19937 rng{ std::random_device{}() };
+    Screening scr;
+    Surrogate model;
+    std::vector<Individual> skippedPop;
+    std::vector<std::array<float, 4>> predicted; // per pop index, when hasPred
+    std::vector<char> hasPred;
+    ScreenStats scrStats;
 
     // core helpers
-    static bool dominates(const Individual& a, const Individual& b);
-    void assignRanks();
-    void calcCrowding(std::vector<Individual*>& front);
-    Individual tournament();
+    void assignRanks(std::vector<Individual>& v);
+    const Individual& tournament();
+    void crossover(Individual& a, Individual& b);
+    void mutate(Individual& ind);
+    void decode(Individual& ind) const;
+    void screen();
+    static void measured(const Individual& ind, float* m);
 
     // fallback clamp (works even if std::clamp missing)
     template<typename T>
@@ -0,0 +1,196 @@
+﻿#include "ParetoSort.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+// ─── dominance test ──────────────────────────────────────────────────────────
+bool dominatesKey(const float* a, const float* b)
+{
+    bool better = false;
+    for (int k = 0; k < NOBJ; ++k) {
+        if (a[k] > b[k]) return false;           // worse in at least one
+        if (a[k] < b[k]) better = true;          // strictly better somewhere
+    }
+    return better;
+}
+
+// ─── divide and conquer ──────────────────────────────────────────────────────
+// Sweep items are distinct-row indices: u ≥ 0 is a ranked row that may
+// dominate, ~q a row whose rank is being raised. Ties sort updates first,
+// so "before in the sweep" means ≤ on that objective.
+int NonDominatedSort::sweepKey(int item, const std::vector<int>& c) const
+{
+    return item >= 0 ? 2 * c[item] : 2 * c[~item] + 1;
+}
+
+// buf[lo,hi) is in objective-1 order, so every update of the first half is
+// ≤ on it than every query of the second; merging the halves by objective 2
+// leaves only objective 3 to the Fenwick tree. Returns buf in objective-2
+// order for the caller's merge.
+void NonDominatedSort::sweep(int lo, int hi)
+{
+    if (hi - lo < 2) return;
+    const int mid = (lo + hi) / 2;
+    sweep(lo, mid);
+    sweep(mid, hi);
+
+    const int size = (int)fen.size() - 1;
+    int i = lo;
+    for (int j = mid; j < hi; ++j) {
+        if (buf[j] >= 0) continue;
+        const int q = ~buf[j], kq = sweepKey(buf[j], c2);
+        for (; i < mid && sweepKey(buf[i], c2) <= kq; ++i)
+            if (buf[i] >= 0)
+                for (int k = c3[buf[i]] + 1; k <= size; k += k & -k) fen[k] = std::max(fen[k], r[buf[i]]);
+        int best = -1;
+        for (int k = c3[q] + 1; k > 0; k -= k & -k) best = std::max(best, fen[k]);
+        r[q] = std::max(r[q], best + 1);
+    }
+    for (int j = lo; j < i; ++j)                 // undo this level's updates
+        if (buf[j] >= 0)
+            for (int k = c3[buf[j]] + 1; k <= size; k += k & -k) fen[k] = -1;
+
+    std::merge(buf.begin() + lo, buf.begin() + mid, buf.begin() + mid, buf.begin() + hi,
+        tmp.begin() + lo, [this](int a, int b) { return sweepKey(a, c2) < sweepKey(b, c2); });
+    std::copy(tmp.begin() + lo, tmp.begin() + hi, buf.begin() + lo);
+}
+
+// ranks of distinct rows [lo,hi), given everything before lo is final
+void NonDominatedSort::solve(int lo, int hi)
+{
+    if (hi - lo <= 32) {                         // small blocks: direct scan
+        for (int t = lo + 1; t < hi; ++t)
+            for (int u = lo; u < t; ++u)
+                if (r[u] >= r[t] && c1[u] <= c1[t] && c2[u] <= c2[t] && c3[u] <= c3[t]) r[t] = r[u] + 1;
+        return;
+    }
+    const int mid = (lo + hi) / 2;
+    solve(lo, mid);
+
+    int n = 0;
+    for (int u = lo; u < mid; ++u) buf[n++] = u;
+    for (int q = mid; q < hi; ++q) buf[n++] = ~q;
+    std::sort(buf.begin(), buf.begin() + n,
+        [this](int a, int b) { return sweepKey(a, c1) < sweepKey(b, c1); });
+    sweep(0, n);
+
+    solve(mid, hi);
+}
+
+int NonDominatedSort::sort(const float* keys, int n, int* rank)
+{
+    static_assert(NOBJ == 4, "one objective by order, two by recursion, one by Fenwick tree");
+    order.resize(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [keys](int a, int b) {
+        const float* x = keys + a * NOBJ, * y = keys + b * NOBJ;
+        for (int k = 0; k < NOBJ; ++k)
+            if (x[k] != y[k]) return x[k] < y[k];
+        return a < b;
+        });
+
+    // identical rows do not dominate each other: rank one copy
+    uniq.clear();
+    ofRow.resize(n);
+    for (int a : order) {
+        if (uniq.empty() || !std::equal(keys + a * NOBJ, keys + (a + 1) * NOBJ, keys + uniq.back() * NOBJ))
+            uniq.push_back(a);
+        ofRow[a] = (int)uniq.size() - 1;
+    }
+    const int m = (int)uniq.size();
+
+    // objectives 1..3 as dense integer ranks (ties stay ties)
+    int levels = 0;
+    std::vector<int>* cs[3] = { &c1, &c2, &c3 };
+    tmp.resize(m);
+    for (int d = 0; d < 3; ++d) {
+        std::vector<int>& c = *cs[d];
+        const float* col = keys + d + 1;
+        c.resize(m);
+        std::iota(tmp.begin(), tmp.end(), 0);
+        std::sort(tmp.begin(), tmp.end(),
+            [&](int a, int b) { return col[uniq[a] * NOBJ] < col[uniq[b] * NOBJ]; });
+        levels = 0;
+        for (int k = 0; k < m; ++k) {
+            if (k && col[uniq[tmp[k]] * NOBJ] != col[uniq[tmp[k - 1]] * NOBJ]) ++levels;
+            c[tmp[k]] = levels;
+        }
+    }
+
+    r.assign(m, 0);
+    buf.resize(m);
+    fen.assign(levels + 2, -1);
+    solve(0, m);
+
+    int fronts = 0;
+    for (int i = 0; i < n; ++i) {
+        rank[i] = r[ofRow[i]];
+        fronts = std::max(fronts, rank[i] + 1);
+    }
+    return fronts;
+}
+
+// ─── crowding distance ───────────────────────────────────────────────────────
+void NonDominatedSort::crowding(const float* keys, const int* rank, int n, int fronts, float* crowd)
+{
+    frontStart.assign(fronts + 1, 0);            // counting sort by front
+    for (int i = 0; i < n; ++i) ++frontStart[rank[i] + 1];
+    for (int f = 0; f < fronts; ++f) frontStart[f + 1] += frontStart[f];
+    members.resize(n);
+    std::vector<int>& cursor = order;            // reused as write positions
+    cursor.assign(frontStart.begin(), frontStart.end() - 1);
+    for (int i = 0; i < n; ++i) members[cursor[rank[i]]++] = i;
+
+    for (int f = 0; f < fronts; ++f) {
+        const int* F = members.data() + frontStart[f];
+        const int s = frontStart[f + 1] - frontStart[f];
+        for (int i = 0; i < s; ++i) crowd[F[i]] = 0.0f;
+
+        for (int m = 0; m < NOBJ; ++m) {
+            byObj.resize(s);
+            for (int i = 0; i < s; ++i) byObj[i] = { keys[F[i] * NOBJ + m], F[i] };
+            std::sort(byObj.begin(), byObj.end());
+
+            crowd[byObj.front().second] = crowd[byObj.back().second] = INFINITY;
+            float minv = byObj.front().first, maxv = byObj.back().first;
+            if (maxv - minv == 0) continue;
+
+            for (int i = 1; i < s - 1; ++i)
+                crowd[byObj[i].second] += (byObj[i + 1].first - byObj[i - 1].first) / (maxv - minv);
+        }
+    }
+}
+
+// ─── reference: Deb's fast non-dominated sort ────────────────────────────────
+int referenceSort(const float* keys, int n, int* rank)
+{
+    std::vector<std::vector<int>> fronts;
+    std::vector<int> dominated(n, 0);
+    std::vector<std::vector<int>> domList(n);
+
+    for (int p = 0; p < n; ++p)
+        for (int q = 0; q < n; ++q) if (p != q) {
+            if (dominatesKey(keys + p * NOBJ, keys + q * NOBJ)) domList[p].push_back(q);
+            else if (dominatesKey(keys + q * NOBJ, keys + p * NOBJ)) ++dominated[p];
+        }
+
+    for (int i = 0; i < n; ++i) if (!dominated[i]) {
+        rank[i] = 0;
+        if (fronts.empty()) fronts.emplace_back();
+        fronts[0].push_back(i);
+    }
+
+    int i = 0;
+    while (i < (int)fronts.size()) {
+        std::vector<int> next;
+        for (int p : fronts[i])
+            for (int q : domList[p])
+                if (--dominated[q] == 0) {
+                    rank[q] = i + 1;
+                    next.push_back(q);
+                }
+        if (!next.empty()) fronts.push_back(std::move(next));
+        ++i;
+    }
+    return (int)fronts.size();
+}
@@ -0,0 +1,82 @@
+﻿#pragma once
+#include <utility>
+#include <vector>
+
+// ─── non-dominated sorting on flat objective rows ────────────────────────────
+// Objective vectors are rows of NOBJ floats, all minimised (callers flip the
+// sign of maximised objectives). a dominates b: a ≤ b everywhere, < somewhere.
+constexpr int NOBJ = 4;
+
+bool dominatesKey(const float* a, const float* b);
+
+// Divide-and-conquer non-dominated sort (Jensen / Fortin et al.): with rows
+// in lexicographic order only earlier rows can dominate a later one, and
+// rank(s) = 1 + max rank of its dominators. The rows are halved recursively;
+// once the left half is ranked it raises the ranks of the right half through
+// an offline 3-D dominance query on objectives 1..3 (sort on 1, recurse on 2,
+// prefix-max Fenwick tree on 3), then the right half is solved. O(N log³ N)
+// whatever the front structure; identical rows share one rank. All buffers
+// are flat and kept between calls.
+class NonDominatedSort {
+public:
+    // rank[i] = front of row i (0 = non-dominated); returns the front count
+    int sort(const float* keys, int n, int* rank);
+
+    // crowding distance of every row within its front (ranks from sort())
+    void crowding(const float* keys, const int* rank, int n, int fronts, float* crowd);
+
+private:
+    std::vector<int> order, uniq, ofRow;         // lex order, distinct rows, row → distinct
+    std::vector<int> c1, c2, c3;                 // compressed objectives 1..3
+    std::vector<int> r;                          // ranks of the distinct rows
+    std::vector<int> buf, tmp, fen;              // sweep items, merge scratch, Fenwick tree
+    std::vector<int> frontStart, members;        // rows bucketed by front
+    std::vector<std::pair<float, int>> byObj;    // (value, row) of one front
+
+    void solve(int lo, int hi);
+    void sweep(int lo, int hi);
+    int  sweepKey(int item, const std::vector<int>& c) const;
+};
+
+// textbook O(M·N²) sort with per-call domination lists (the original
+// NSGAII::assignRanks), kept as the reference for --bench-sort
+int referenceSort(const float* keys, int n, int* rank);
+
+// ─── incremental Pareto archive ──────────────────────────────────────────────
+// The non-dominated set of everything inserted so far, updated one vector at
+// a time in O(M·|archive|): a dominated (or duplicate) vector is rejected,
+// otherwise the members it dominates are dropped and it joins.
+template <class T>
+class ParetoArchive {
+public:
+    bool insert(const float* key, const T& item)
+    {
+        const int n = size();
+        for (int i = 0; i < n; ++i) {
+            const float* m = &keys[i * NOBJ];
+            bool same = true;
+            for (int k = 0; k < NOBJ && same; ++k) same = m[k] == key[k];
+            if (same || dominatesKey(m, key)) return false;
+        }
+        for (int i = 0; i < size();) {           // swap-remove what it dominates
+            if (!dominatesKey(key, &keys[i * NOBJ])) { ++i; continue; }
+            const int last = size() - 1;
+            for (int k = 0; k < NOBJ; ++k) keys[i * NOBJ + k] = keys[last * NOBJ + k];
+            items[i] = std::move(items[last]);
+            keys.resize(last * NOBJ);
+            items.pop_back();
+        }
+        keys.insert(keys.end(), key, key + NOBJ);
+        items.push_back(item);
+        return true;
+    }
+    void clear() { keys.clear(); items.clear(); }
+
+    int size() const { return (int)items.size(); }
+    const float* key(int i) const { return &keys[i * NOBJ]; }
+    const std::vector<T>& members() const { return items; }
+
+private:
+    std::vector<float> keys;                     // size()·NOBJ
+    std::vector<T> items;
+};
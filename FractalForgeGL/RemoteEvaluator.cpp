@@ -0,0 +1,497 @@
+﻿#include "RemoteEvaluator.h"
+#include "FitnessCache.h"
+#include "Snapshot.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "ws2_32.lib")
+#endif
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// ─── sockets (Winsock / BSD) ─────────────────────────────────────────────────
+// handles travel as intptr_t, -1 = none (INVALID_SOCKET on Windows)
+namespace {
+#ifdef _WIN32
+    using Native = SOCKET;
+    using PollFd = WSAPOLLFD;
+    int  pollFds(PollFd* f, std::size_t n, int ms) { return WSAPoll(f, ULONG(n), ms); }
+    int  sendSome(std::intptr_t s, const char* p, int n) { return send(Native(s), p, n, 0); }
+    int  recvSome(std::intptr_t s, char* p, int n) { return recv(Native(s), p, n, 0); }
+    void closeSock(std::intptr_t s) { closesocket(Native(s)); }
+    void shutSock(std::intptr_t s) { shutdown(Native(s), SD_BOTH); }
+#else
+    using Native = int;
+    using PollFd = pollfd;
+    int  pollFds(PollFd* f, std::size_t n, int ms) { return poll(f, nfds_t(n), ms); }
+    int  sendSome(std::intptr_t s, const char* p, int n) { return (int)send(Native(s), p, std::size_t(n), 0); }
+    int  recvSome(std::intptr_t s, char* p, int n) { return (int)recv(Native(s), p, std::size_t(n), 0); }
+    void closeSock(std::intptr_t s) { close(Native(s)); }
+    void shutSock(std::intptr_t s) { shutdown(Native(s), SHUT_RDWR); }
+#endif
+
+    // once per process: Winsock up; a send to a dead peer fails instead of
+    // raising SIGPIPE
+    void netInit()
+    {
+        static const bool done = [] {
+#ifdef _WIN32
+            WSADATA d;
+            WSAStartup(MAKEWORD(2, 2), &d);
+#else
+            std::signal(SIGPIPE, SIG_IGN);
+#endif
+            return true;
+        }();
+        (void)done;
+    }
+
+    void noDelay(std::intptr_t s)                // small messages go out at once
+    {
+        int one = 1;
+        setsockopt(Native(s), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&one), sizeof one);
+    }
+
+    bool sendAll(std::intptr_t s, const char* p, std::size_t n)
+    {
+        while (n) {
+            const int k = sendSome(s, p, (int)std::min<std::size_t>(n, 1 << 20));
+            if (k <= 0) return false;
+            p += k; n -= std::size_t(k);
+        }
+        return true;
+    }
+
+    // appends what has arrived, blocking until something has; false once
+    // the peer closed or the connection failed
+    bool receiveSome(std::intptr_t s, std::vector<char>& buf)
+    {
+        char tmp[1 << 16];
+        const int k = recvSome(s, tmp, (int)sizeof tmp);
+        if (k <= 0) return false;
+        buf.insert(buf.end(), tmp, tmp + k);
+        return true;
+    }
+
+    // ─── messages ────────────────────────────────────────────────────────────
+    // HELLO   worker → coordinator: u32 protocol, i32 threads, name
+    // JOBS    coordinator → worker: u32 batch, DeepView, u8 deep, u8 subdivide, EvalJobs
+    // RESULTS worker → coordinator: u32 batch, f32 busy ms, one Fitness per job
+    // HEARTBEAT (worker), BYE (coordinator): no payload
+    enum Msg : std::uint8_t { HELLO = 1, JOBS, RESULTS, HEARTBEAT, BYE };
+    constexpr std::uint32_t PROTOCOL = 1;
+    constexpr std::uint32_t MAX_MESSAGE = 64u << 20;
+    constexpr std::int32_t  MAX_THREADS = 1024;   // in a hello; batches are sized by it
+
+    bool sendMessage(std::intptr_t s, Msg type, const std::vector<char>& payload = {})
+    {
+        ByteWriter w;
+        w.put(std::uint32_t(payload.size() + 1));
+        w.put(std::uint8_t(type));
+        w.bytes.insert(w.bytes.end(), payload.begin(), payload.end());
+        return sendAll(s, w.bytes.data(), w.bytes.size());
+    }
+
+    // moves the first complete message out of buf; false if there is none
+    // yet, or with `bad` set if its length makes no sense
+    bool takeMessage(std::vector<char>& buf, Msg& type, std::vector<char>& payload, bool& bad)
+    {
+        std::uint32_t n;
+        if (buf.size() < sizeof n) return false;
+        std::memcpy(&n, buf.data(), sizeof n);
+        if (n < 1 || n > MAX_MESSAGE) { bad = true; return false; }
+        if (buf.size() < sizeof n + n) return false;
+        type = Msg(std::uint8_t(buf[sizeof n]));
+        payload.assign(buf.begin() + sizeof n + 1, buf.begin() + sizeof n + n);
+        buf.erase(buf.begin(), buf.begin() + sizeof n + n);
+        return true;
+    }
+
+    double msSince(std::chrono::steady_clock::time_point t)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+    }
+}
+
+// ─── coordinator ─────────────────────────────────────────────────────────────
+// jobs of one evaluate() call: what is answered, what waits for a worker
+struct RemoteEvaluator::Round {
+    const std::vector<EvalJob>& jobs;
+    std::vector<Fitness>& out;
+    std::vector<char> done;
+    std::deque<int> queue;
+    int remaining;
+    std::uint32_t id;
+};
+
+RemoteEvaluator::RemoteEvaluator(const char* addr, int port, int batchPerThread, int silentMs, int lateMs)
+    : port(port), batchPerThread(batchPerThread), silentMs(silentMs), lateMs(lateMs)
+{
+    netInit();
+    sockaddr_in a{};
+    a.sin_family = AF_INET;
+    a.sin_port = htons(std::uint16_t(port));
+    if (inet_pton(AF_INET, addr, &a.sin_addr) != 1) { std::cerr << "Bad address " << addr << "\n"; return; }
+
+    const std::intptr_t s = (std::intptr_t)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == -1) { std::cerr << "Cannot create a socket\n"; return; }
+    int one = 1;
+    setsockopt(Native(s), SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&one), sizeof one);
+    if (bind(Native(s), reinterpret_cast<const sockaddr*>(&a), sizeof a) || listen(Native(s), 64)) {
+        std::cerr << "Cannot listen on " << addr << ":" << port << "\n";
+        closeSock(s);
+        return;
+    }
+    listener = s;
+}
+
+RemoteEvaluator::~RemoteEvaluator()
+{
+    for (auto& w : workers) { sendMessage(w->sock, BYE); closeSock(w->sock); }
+    if (listener != -1) closeSock(listener);
+}
+
+void RemoteEvaluator::accept()
+{
+    for (;;) {
+        PollFd p{ Native(listener), POLLIN, 0 };
+        if (pollFds(&p, 1, 0) <= 0 || !(p.revents & POLLIN)) return;
+        const std::intptr_t s = (std::intptr_t)::accept(Native(listener), nullptr, nullptr);
+        if (s == -1) return;
+        noDelay(s);
+        auto w = std::make_unique<Worker>();
+        w->sock = s;
+        w->seen = w->joined = clock::now();
+        workers.push_back(std::move(w));
+    }
+}
+
+void RemoteEvaluator::evaluate(const std::vector<EvalJob>& jobs,
+    const DeepView& view, std::vector<Fitness>& out,
+    FitnessCache* cache)
+{
+    out.resize(jobs.size());
+
+    // only the first job of each uncached genome is sent, as in BatchEvaluator
+    std::vector<int> todo, dupes;
+    std::unordered_map<std::uint64_t, int> pending;
+    if (cache) cache->setView(view);
+    for (int k = 0; k < (int)jobs.size(); ++k) {
+        if (!cache) { todo.push_back(k); continue; }
+        if (pending.count(jobs[k].g.key())) { dupes.push_back(k); continue; }
+        if (cache->lookup(jobs[k].g, out[k])) continue;
+        pending.emplace(jobs[k].g.key(), k);
+        todo.push_back(k);
+    }
+
+    Round r{ jobs, out, std::vector<char>(jobs.size(), 0),
+        std::deque<int>(todo.begin(), todo.end()), (int)todo.size(), ++rounds };
+    bool waiting = false;
+    std::vector<PollFd> fds;
+    while (r.remaining > 0) {
+        accept();
+        if (workers.empty() && !waiting) {
+            std::cerr << "Waiting for workers on port " << port << "\n";
+            waiting = true;
+        }
+        dispatch(r, view);
+
+        fds.clear();
+        for (auto& w : workers) fds.push_back({ Native(w->sock), POLLIN, 0 });
+        fds.push_back({ Native(listener), POLLIN, 0 });   // wakes up for a new worker
+        pollFds(fds.data(), fds.size(), 50);
+
+        for (std::size_t i = workers.size(); i-- > 0;) {  // backwards: drop() erases
+            Worker& w = *workers[i];
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                if (!receiveSome(w.sock, w.in)) { drop(r, i, "disconnected"); continue; }
+                w.seen = clock::now();
+                if (!receive(r, w)) { drop(r, i, "sent a bad message"); continue; }
+            }
+            if (msSince(w.seen) > silentMs) { drop(r, i, "timed out"); continue; }
+            if (w.busy && !w.late && w.round == r.id && msSince(w.sent) > lateMs) {
+                w.late = true;
+                requeue(r, w);
+            }
+        }
+    }
+
+    if (!cache) return;
+    for (int k : todo) cache->store(jobs[k].g, out[k]);
+    for (int k : dupes) cache->lookup(jobs[k].g, out[k]);
+}
+
+// idle workers get the front of the queue, at most batchPerThread jobs per
+// thread each, and no more than an even share of what is left
+void RemoteEvaluator::dispatch(Round& r, const DeepView& view)
+{
+    int idle = 0;
+    for (auto& w : workers) idle += !w->busy && w->st.threads > 0;
+    std::vector<EvalJob> batch;
+    for (auto& wp : workers) {
+        Worker& w = *wp;
+        if (w.busy || w.st.threads == 0) continue;  // no hello yet
+        while (!r.queue.empty() && r.done[r.queue.front()]) r.queue.pop_front();
+        if (r.queue.empty()) return;
+        const int share = int((r.queue.size() + idle - 1) / idle);
+        const int n = std::min(share, std::max(1, w.st.threads * batchPerThread));
+        --idle;
+
+        batch.clear();
+        w.batch.clear();
+        while ((int)batch.size() < n && !r.queue.empty()) {
+            const int k = r.queue.front();
+            r.queue.pop_front();
+            if (r.done[k]) continue;             // a late batch's copy, answered meanwhile
+            w.batch.push_back(k);
+            batch.push_back(r.jobs[k]);
+        }
+        ByteWriter m;
+        m.put(++nextBatch);
+        m.put(view);
+        m.put(std::uint8_t(deep));
+        m.put(std::uint8_t(subdivide));
+        m.putVec(batch);
+        if (!sendMessage(w.sock, JOBS, m.bytes)) shutSock(w.sock);   // dropped on the next poll
+        w.busy = true;
+        w.late = false;
+        w.batchId = nextBatch;
+        w.round = r.id;
+        w.sent = clock::now();
+    }
+}
+
+// every complete message w has sent; false on a protocol error
+bool RemoteEvaluator::receive(Round& r, Worker& w)
+{
+    Msg type;
+    std::vector<char> payload;
+    bool bad = false;
+    while (takeMessage(w.in, type, payload, bad)) {
+        ByteReader in(payload);
+        if (type == HELLO) {
+            std::uint32_t version = 0;
+            std::int32_t threads = 0;
+            in.get(version);
+            in.get(threads);
+            in.getStr(w.st.name);
+            if (!in.ok() || version != PROTOCOL || threads < 1 || threads > MAX_THREADS
+                || w.st.threads) return false;
+            w.st.threads = threads;
+            std::cout << "Worker " << w.st.name << " joined, " << threads << " threads\n";
+        }
+        else if (type == RESULTS) {
+            std::uint32_t id = 0;
+            float busyMs = 0;
+            std::vector<Fitness> f;
+            in.get(id);
+            in.get(busyMs);
+            in.getVec(f);
+            if (!in.ok() || !w.busy || id != w.batchId || f.size() != w.batch.size()) return false;
+            w.busy = false;
+            ++w.st.batches;
+            w.st.jobs += (long long)f.size();
+            w.st.busyMs += busyMs;
+            if (w.round != r.id) continue;       // a late batch of an earlier call
+            for (std::size_t i = 0; i < f.size(); ++i) {
+                const int k = w.batch[i];
+                if (r.done[k]) continue;         // its copy was faster
+                r.out[k] = f[i];
+                r.done[k] = 1;
+                --r.remaining;
+            }
+        }
+        else if (type != HEARTBEAT) return false;
+    }
+    return !bad;
+}
+
+// the unanswered jobs of w's batch go to the front of the queue
+void RemoteEvaluator::requeue(Round& r, Worker& w)
+{
+    if (!w.busy || w.round != r.id) return;
+    for (auto it = w.batch.rbegin(); it != w.batch.rend(); ++it) {
+        if (r.done[*it] || std::find(r.queue.begin(), r.queue.end(), *it) != r.queue.end()) continue;
+        r.queue.push_front(*it);
+        ++w.st.redispatched;
+    }
+}
+
+void RemoteEvaluator::drop(Round& r, std::size_t i, const char* why)
+{
+    Worker& w = *workers[i];
+    std::cerr << "Worker " << (w.st.name.empty() ? "(no hello)" : w.st.name) << " " << why
+        << (w.busy && w.round == r.id ? ", its batch is re-queued" : "") << "\n";
+    requeue(r, w);
+    closeSock(w.sock);
+    w.st.lost = true;
+    w.st.connectedSec = msSince(w.joined) / 1000.0;
+    if (w.st.threads) departed.push_back(w.st);
+    workers.erase(workers.begin() + std::ptrdiff_t(i));
+}
+
+std::vector<WorkerStats> RemoteEvaluator::stats() const
+{
+    std::vector<WorkerStats> all = departed;
+    for (auto& w : workers) {
+        if (!w->st.threads) continue;
+        all.push_back(w->st);
+        all.back().connectedSec = msSince(w->joined) / 1000.0;
+    }
+    return all;
+}
+
+// ─── worker ──────────────────────────────────────────────────────────────────
+namespace {
+    std::intptr_t connectTo(const char* host, int port)
+    {
+        addrinfo hints{}, * res = nullptr;
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        if (getaddrinfo(host, std::to_string(port).c_str(), &hints, &res)) return -1;
+        std::intptr_t s = -1;
+        for (addrinfo* a = res; a && s == -1; a = a->ai_next) {
+            s = (std::intptr_t)socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+            if (s == -1) continue;
+            if (connect(Native(s), a->ai_addr, (int)a->ai_addrlen)) { closeSock(s); s = -1; }
+        }
+        freeaddrinfo(res);
+        if (s != -1) noDelay(s);
+        return s;
+    }
+
+    // host name and local port: tells workers on one machine apart
+    std::string localName(std::intptr_t s)
+    {
+        char host[256] = "?";
+        gethostname(host, sizeof host - 1);
+        sockaddr_storage a{};
+        socklen_t n = sizeof a;
+        int port = 0;
+        if (!getsockname(Native(s), reinterpret_cast<sockaddr*>(&a), &n)) {
+            if (a.ss_family == AF_INET) port = ntohs(reinterpret_cast<sockaddr_in*>(&a)->sin_port);
+            else if (a.ss_family == AF_INET6) port = ntohs(reinterpret_cast<sockaddr_in6*>(&a)->sin6_port);
+        }
+        return std::string(host) + ":" + std::to_string(port);
+    }
+}
+
+RemoteWorker::RemoteWorker(BatchEvaluator& eval, const GenomeBounds& bounds, int heartbeatMs, int retrySec)
+    : eval(eval), bounds(bounds), heartbeatMs(heartbeatMs), retrySec(retrySec)
+{
+    netInit();
+}
+
+int RemoteWorker::run(const char* host, int port)
+{
+    auto lastContact = std::chrono::steady_clock::now();
+    for (;;) {
+        const std::intptr_t s = connectTo(host, port);
+        if (s == -1) {
+            if (msSince(lastContact) > retrySec * 1000.0) {
+                std::cerr << "No coordinator at " << host << ":" << port << "\n";
+                return 1;
+            }
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            continue;
+        }
+        std::cout << "Connected to " << host << ":" << port << "\n";
+        const int rc = serve(s);
+        closeSock(s);
+        if (rc == 0) break;
+        std::cerr << "Lost the coordinator, reconnecting\n";
+        lastContact = std::chrono::steady_clock::now();
+    }
+    std::cout << "Worker done: " << batches << " batches, " << jobs << " jobs\n";
+    return 0;
+}
+
+int RemoteWorker::serve(std::intptr_t s)
+{
+    std::mutex sendLock;                         // results and heartbeats share the socket
+    auto post = [&](Msg type, const std::vector<char>& payload) {
+        std::lock_guard<std::mutex> lk(sendLock);
+        return sendMessage(s, type, payload);
+    };
+    ByteWriter hello;
+    hello.put(PROTOCOL);
+    hello.put(std::int32_t(eval.workers()));
+    hello.putStr(localName(s));
+    if (!post(HELLO, hello.bytes)) return -1;
+
+    // heartbeats keep coming while a long batch renders
+    std::mutex m;
+    std::condition_variable wake;
+    bool stop = false;
+    std::thread beat([&] {
+        std::unique_lock<std::mutex> lk(m);
+        while (!wake.wait_for(lk, std::chrono::milliseconds(heartbeatMs), [&] { return stop; }))
+            if (!post(HEARTBEAT, {})) return;
+        });
+
+    std::vector<char> in, payload;
+    std::vector<EvalJob> batch;
+    std::vector<Fitness> out;
+    Msg type;
+    bool bad = false;
+    int rc = -1;
+    while (rc == -1 && !bad && receiveSome(s, in)) {
+        while (rc == -1 && takeMessage(in, type, payload, bad)) {
+            if (type == BYE) { rc = 0; break; }
+            ByteReader msg(payload);
+            std::uint32_t id = 0;
+            DeepView view;
+            std::uint8_t deep = 0, subdivide = 0;
+            msg.get(id);
+            msg.get(view);
+            msg.get(deep);
+            msg.get(subdivide);
+            msg.getVec(batch);
+            if (type != JOBS || !msg.ok()) { bad = true; break; }
+            for (const EvalJob& j : batch) bad |= !inBounds(j.g, bounds);
+            if (bad) break;                      // would not fit the buffers
+
+            const auto t0 = std::chrono::steady_clock::now();
+            eval.setDeepZoom(deep != 0);
+            eval.setSubdivision(subdivide != 0);
+            eval.evaluate(batch, view, out);
+            ByteWriter res;
+            res.put(id);
+            res.put(float(msSince(t0)));
+            res.putVec(out);
+            post(RESULTS, res.bytes);            // a lost connection shows up in recv
+            ++batches;
+            jobs += (long long)batch.size();
+        }
+    }
+    if (bad) std::cerr << "Bad message from the coordinator\n";
+
+    {
+        std::lock_guard<std::mutex> lk(m);
+        stop = true;
+    }
+    wake.notify_all();
+    beat.join();
+    return rc;
+}
@@ -0,0 +1,100 @@
+﻿#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "BatchEvaluator.h"
+
+class FitnessCache;
+
+// ─── distributed evaluation over TCP ─────────────────────────────────────────
+// The coordinator (a headless run) listens on a port; workers connect, say
+// how many render threads they have, and are sent batches of jobs plus the
+// view. Each answers a batch with one Fitness per job, rendered on its own
+// BatchEvaluator, so the time objectives are the worker's. Messages are
+// {u32 length, u8 type, ByteWriter payload} in the sender's byte order: every
+// node runs the same build (the hello carries the protocol version). There
+// is no authentication, so keep the port on a trusted network.
+//
+// Workers send a heartbeat every few hundred ms, busy or not. One that is
+// silent for `silentMs`, or whose connection drops, is removed and the
+// unanswered jobs of its batch go back to the queue. A batch still out after
+// `lateMs` is queued again for whoever is idle; the first answer wins.
+
+// what one worker did while connected
+struct WorkerStats {
+    std::string name;                            // host:port the worker reported
+    int       threads = 0;
+    long long batches = 0, jobs = 0;             // answered
+    long long redispatched = 0;                  // its jobs sent elsewhere (late or lost)
+    double    busyMs = 0;                        // rendering, as the worker timed it
+    double    connectedSec = 0;
+    bool      lost = false;                      // timed out or disconnected
+};
+
+class RemoteEvaluator {
+public:
+    // listens on addr:port (an IPv4 interface address; "127.0.0.1": this
+    // host only, "0.0.0.0": all interfaces); ok() false if it cannot be bound
+    RemoteEvaluator(const char* addr, int port, int batchPerThread, int silentMs, int lateMs);
+    ~RemoteEvaluator();                          // tells the workers to exit
+    RemoteEvaluator(const RemoteEvaluator&) = delete;
+    RemoteEvaluator& operator=(const RemoteEvaluator&) = delete;
+
+    bool ok() const { return listener != -1; }
+    void setDeepZoom(bool on) { deep = on; }
+    void setSubdivision(bool on) { subdivide = on; }
+
+    // as BatchEvaluator::evaluate(); blocks until every job is answered,
+    // waiting for workers to connect if there are none
+    void evaluate(const std::vector<EvalJob>& jobs,
+        const DeepView& view, std::vector<Fitness>& out,
+        FitnessCache* cache = nullptr);
+
+    std::vector<WorkerStats> stats() const;      // connected and departed workers
+
+private:
+    using clock = std::chrono::steady_clock;
+    struct Round;
+    struct Worker {
+        std::intptr_t sock;
+        WorkerStats   st;
+        std::vector<char> in;                    // received, not yet parsed
+        clock::time_point seen, joined, sent;
+        bool          busy = false, late = false;
+        std::uint32_t batchId = 0, round = 0;    // outstanding batch, and its evaluate() call
+        std::vector<int> batch;                  // job indices of it
+    };
+
+    std::intptr_t listener = -1;
+    int  port, batchPerThread, silentMs, lateMs;
+    bool deep = false, subdivide = false;
+    std::uint32_t nextBatch = 0, rounds = 0;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<WorkerStats> departed;
+
+    void accept();
+    void dispatch(Round& r, const DeepView& view);
+    bool receive(Round& r, Worker& w);           // false: protocol error
+    void drop(Round& r, std::size_t i, const char* why);
+    void requeue(Round& r, Worker& w);
+};
+
+// ─── worker side ─────────────────────────────────────────────────────────────
+// connects to the coordinator and evaluates what it is sent until told to
+// stop; after a lost connection it keeps retrying for retrySec. A batch with
+// a genome outside `bounds` is a bad message, like a malformed one.
+class RemoteWorker {
+public:
+    RemoteWorker(BatchEvaluator& eval, const GenomeBounds& bounds, int heartbeatMs, int retrySec);
+    int run(const char* host, int port);         // 0 once the coordinator says bye
+
+private:
+    BatchEvaluator& eval;
+    GenomeBounds bounds;
+    int heartbeatMs, retrySec;
+    long long batches = 0, jobs = 0;
+
+    int serve(std::intptr_t sock);               // 0: bye, -1: connection lost
+};
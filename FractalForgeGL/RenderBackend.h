@@ -0,0 +1,72 @@
+﻿#pragma once
+#include <cstdint>
+#include "DeepZoom.h"
+#include "StageTimer.h"
+
+// ─── what one fitness render is asked to do ──────────────────────────────────
+// The evolved parameters: iteration budget, square fitness buffer of res²
+// pixels, each the box average of supersample² samples, and whether the
+// interior check runs.
+struct Genome {
+    int  maxIter = 256;
+    int  res = 256;
+    int  supersample = 1;
+    bool interior = true;
+
+    int  side() const { return res * supersample; }   // rendered buffer side
+    std::uint64_t key() const {                        // packed, for hashing
+        return std::uint64_t(std::uint32_t(maxIter)) | std::uint64_t(res & 0xffff) << 32
+            | std::uint64_t(supersample & 0xff) << 48 | std::uint64_t(interior) << 56;
+    }
+    bool operator==(const Genome& o) const {
+        return maxIter == o.maxIter && res == o.res && supersample == o.supersample
+            && interior == o.interior;
+    }
+};
+
+// ─── common contract of the GPU and CPU renderers ────────────────────────────
+// Everything the fitness loop needs: set genome + view, render the off-screen
+// fitness buffer, read back its raw iteration counts and the time it took.
+// Counts are 16-bit: maxIter is clamped to MAX_ITER, and an interior pixel
+// holds maxIter. Colour is a display concern (palette LUT, GL only).
+class RenderBackend {
+public:
+    virtual ~RenderBackend() = default;
+
+    virtual void setView(float cx, float cy, float zoom) = 0;
+    virtual void setView(const DeepView& v) = 0;  // extended-precision centre
+    virtual void setMaxIter(int it) = 0;
+    virtual void setDeepZoom(bool on) = 0;        // perturbation kernel
+    // skip interior pixels: cardioid/bulb test + periodicity check; the
+    // counts stay identical, only the time changes (float kernel only)
+    virtual void setInteriorCheck(bool on) = 0;
+
+    virtual void setResolution(int w, int h) = 0; // off-screen buffer size
+
+    virtual void renderOffscreen() = 0;      // fill the off-screen buffer
+
+    virtual float lastGpuTimeMs() const = 0; // CPU backend: wall time
+    virtual const std::uint16_t* iterationPtr() const = 0;   // counts, row 0 = bottom
+    virtual int width() const = 0;           // size of what iterationPtr() holds
+    virtual int height() const = 0;
+    float fps() const { return 1000.0f / lastGpuTimeMs(); }
+
+    // maxIter, side()² buffer and interior check of g
+    void setGenome(const Genome& g) {
+        setMaxIter(g.maxIter);
+        setResolution(g.side(), g.side());
+        setInteriorCheck(g.interior);
+    }
+
+    // optional sink for per-stage times of renderOffscreen() & co. and of
+    // measureFitness() on this backend; one thread at a time
+    void setStageTimes(StageTimes* t) { stages = t; }
+    StageTimes* stageTimes() const { return stages; }
+
+    static constexpr int MAX_ITER = 65535;   // largest count a buffer holds
+    static constexpr int OFF_W = 256;        // default buffer size
+    static constexpr int OFF_H = 256;
+
+protected:
+    StageTimes* stages = nullptr;
+};
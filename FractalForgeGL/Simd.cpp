@@ -0,0 +1,30 @@
+﻿#include "Simd.h"
+
+// ─── runtime CPU detection ───────────────────────────────────────────────────
+#ifdef FF_X86
+static bool cpuHas(SimdLevel s)
+{
+#if defined(_MSC_VER)
+    int r[4]; __cpuid(r, 1);
+    if (s == SimdLevel::SSE2) return (r[3] & (1 << 26)) != 0;
+    if (!(r[2] & (1 << 27)) || !(r[2] & (1 << 28))) return false;  // OSXSAVE + AVX
+    if ((_xgetbv(0) & 6) != 6) return false;                      // OS saves YMM
+    __cpuidex(r, 7, 0);
+    return (r[1] & (1 << 5)) != 0;
+#else
+    return s == SimdLevel::SSE2 ? __builtin_cpu_supports("sse2")
+                                : __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+SimdLevel bestSimd()
+{
+#ifdef FF_X86
+    static const SimdLevel best = cpuHas(SimdLevel::AVX2) ? SimdLevel::AVX2
+        : cpuHas(SimdLevel::SSE2) ? SimdLevel::SSE2 : SimdLevel::Scalar;
+    return best;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
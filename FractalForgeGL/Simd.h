@@ -0,0 +1,21 @@
+﻿#pragma once
+
+// ─── instruction-set selection shared by the CPU kernels ─────────────────────
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FF_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC emits any intrinsic without /arch; GCC/Clang need per-function targets
+#if defined(__GNUC__)
+#define FF_TARGET(isa) __attribute__((target(isa)))
+#else
+#define FF_TARGET(isa)
+#endif
+
+enum class SimdLevel { Scalar, SSE2, AVX2 };
+
+SimdLevel bestSimd();                            // widest level this CPU runs
@@ -0,0 +1,98 @@
+﻿#include "Snapshot.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+// ─── header ──────────────────────────────────────────────────────────────────
+static constexpr char snapshotMagic[8] = { 'F', 'F', 'S', 'N', 'A', 'P', '\0', '\0' };
+
+void beginSnapshot(ByteWriter& out)
+{
+    for (char c : snapshotMagic) out.put(c);
+    out.put(SNAPSHOT_VERSION);
+}
+
+bool checkSnapshot(ByteReader& in, const std::string& fname)
+{
+    char magic[8];
+    for (char& c : magic) in.get(c);
+    std::uint32_t version = 0;
+    in.get(version);
+    if (!in.ok() || std::memcmp(magic, snapshotMagic, sizeof magic)) {
+        std::cerr << fname << ": not a snapshot\n"; return false;
+    }
+    if (version != SNAPSHOT_VERSION) {
+        std::cerr << fname << ": snapshot version " << version << " not supported\n"; return false;
+    }
+    return true;
+}
+
+// ─── writer ──────────────────────────────────────────────────────────────────
+SnapshotWriter::SnapshotWriter() : thread(&SnapshotWriter::loop, this) {}
+
+SnapshotWriter::~SnapshotWriter()
+{
+    {
+        std::lock_guard<std::mutex> lk(m);
+        quit = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+void SnapshotWriter::submit(const std::string& path, std::vector<char>&& bytes)
+{
+    {
+        std::lock_guard<std::mutex> lk(m);
+        if (hasPending) ++nDropped;
+        pendingPath = path;
+        pending = std::move(bytes);
+        hasPending = true;
+    }
+    wake.notify_one();
+}
+
+void SnapshotWriter::loop()
+{
+    std::unique_lock<std::mutex> lk(m);
+    for (;;) {
+        wake.wait(lk, [this] { return hasPending || quit; });
+        if (!hasPending) return;                 // quit with nothing left
+        std::string path = std::move(pendingPath);
+        std::vector<char> bytes = std::move(pending);
+        hasPending = false;
+        lk.unlock();
+
+        const std::string tmp = path + ".tmp";
+        bool ok;
+        {
+            std::ofstream f(tmp, std::ios::out | std::ios::binary | std::ios::trunc);
+            ok = f.write(bytes.data(), bytes.size()).good();
+        }
+        // only a complete file replaces the old one, in one step
+#ifdef _WIN32
+        ok = ok && MoveFileExA(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+        ok = ok && std::rename(tmp.c_str(), path.c_str()) == 0;
+#endif
+        if (ok) ++nWritten;
+        else std::cerr << "Snapshot " << path << " not written\n";
+        lk.lock();
+    }
+}
+
+// ─── reader ──────────────────────────────────────────────────────────────────
+bool readSnapshot(const std::string& fname, std::vector<char>& bytes)
+{
+    std::ifstream f(fname, std::ios::binary | std::ios::ate);
+    if (!f) { std::cerr << "Cannot open snapshot " << fname << "\n"; return false; }
+    bytes.resize((std::size_t)f.tellg());
+    f.seekg(0);
+    if (!f.read(bytes.data(), bytes.size())) { std::cerr << "Cannot read " << fname << "\n"; return false; }
+    return true;
+}
@@ -0,0 +1,120 @@
+﻿#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// ─── snapshot byte streams ───────────────────────────────────────────────────
+// Flat records of trivially copyable values in native byte order, as laid
+// out by this build: a snapshot is for resuming on the same binary, and the
+// version below changes whenever a saved struct does, or the meaning of the
+// values in it (2: boundary/density measured on full iteration counts;
+// 3: the --checkpoint interval).
+constexpr std::uint32_t SNAPSHOT_VERSION = 3;
+
+class ByteWriter {
+public:
+    template<class T>
+    void put(const T& v)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "raw bytes only");
+        const char* p = reinterpret_cast<const char*>(&v);
+        bytes.insert(bytes.end(), p, p + sizeof v);
+    }
+    template<class T>
+    void putVec(const std::vector<T>& v)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "raw bytes only");
+        put(std::uint64_t(v.size()));
+        const char* p = reinterpret_cast<const char*>(v.data());
+        bytes.insert(bytes.end(), p, p + v.size() * sizeof(T));
+    }
+    void putStr(const std::string& s) { putVec(std::vector<char>(s.begin(), s.end())); }
+
+    std::vector<char> bytes;
+};
+
+// reads what ByteWriter wrote; an overrun sets ok() false and leaves the
+// targets value-initialised, so callers check once at the end
+class ByteReader {
+public:
+    explicit ByteReader(const std::vector<char>& b) : p(b.data()), end(b.data() + b.size()) {}
+
+    template<class T>
+    void get(T& v)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "raw bytes only");
+        if (!take(sizeof v)) { v = T(); return; }
+        std::memcpy(&v, p - sizeof v, sizeof v);
+    }
+    template<class T>
+    void getVec(std::vector<T>& v)
+    {
+        std::uint64_t n = 0;
+        get(n);
+        if (!good || n > std::uint64_t(end - p) / sizeof(T)) { good = false; v.clear(); return; }
+        v.resize((std::size_t)n);
+        std::memcpy(v.data(), p, v.size() * sizeof(T));
+        p += v.size() * sizeof(T);
+    }
+    void getStr(std::string& s)
+    {
+        std::vector<char> v;
+        getVec(v);
+        s.assign(v.begin(), v.end());
+    }
+
+    bool ok() const { return good; }
+    void fail() { good = false; }                // a value made no sense
+
+private:
+    const char* p, * end;
+    bool good = true;
+
+    bool take(std::size_t n)
+    {
+        if (!good || std::size_t(end - p) < n) return good = false;
+        p += n;
+        return true;
+    }
+};
+
+// magic + version up front; false (with a message) if the file is not ours
+void beginSnapshot(ByteWriter& out);
+bool checkSnapshot(ByteReader& in, const std::string& fname);
+
+// ─── background snapshot writer ──────────────────────────────────────────────
+// submit() hands over the bytes and returns at once; a thread writes them to
+// `path`.tmp and renames it over `path`, so the previous snapshot survives a
+// crash mid-write. If a write is still running, the newest submission waits
+// and any older waiting one is dropped.
+class SnapshotWriter {
+public:
+    SnapshotWriter();
+    ~SnapshotWriter();                           // finishes the pending write
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    void submit(const std::string& path, std::vector<char>&& bytes);
+
+    int written() const { return nWritten; }
+    int dropped() const { return nDropped; }
+
+private:
+    std::mutex m;
+    std::condition_variable wake;
+    std::string pendingPath;
+    std::vector<char> pending;
+    bool hasPending = false, quit = false;
+    std::atomic<int> nWritten{ 0 }, nDropped{ 0 };
+    std::thread thread;
+
+    void loop();
+};
+
+bool readSnapshot(const std::string& fname, std::vector<char>& bytes);
@@ -0,0 +1,55 @@
+﻿#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// ─── single-producer / single-consumer ring ──────────────────────────────────
+// Lock-free and wait-free: push() from one thread only, pop() from one other.
+// Capacity is rounded up to a power of two; each side caches the other's
+// index so the shared cache lines are only touched when the ring looks full
+// (producer) or empty (consumer).
+template <class T>
+class SpscRing {
+public:
+    explicit SpscRing(std::size_t capacity)
+    {
+        std::size_t c = 2;
+        while (c < capacity) c <<= 1;
+        slots.resize(c);
+        mask = c - 1;
+    }
+
+    bool push(const T& v)
+    {
+        const std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - headSeen > mask) {
+            headSeen = head.load(std::memory_order_acquire);
+            if (t - headSeen > mask) return false;   // full
+        }
+        slots[t & mask] = v;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& v)
+    {
+        const std::size_t h = head.load(std::memory_order_relaxed);
+        if (h == tailSeen) {
+            tailSeen = tail.load(std::memory_order_acquire);
+            if (h == tailSeen) return false;        // empty
+        }
+        v = slots[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::size_t capacity() const { return mask + 1; }
+
+private:
+    std::vector<T> slots;
+    std::size_t mask = 0;
+    alignas(64) std::atomic<std::size_t> head{ 0 };  // consumer writes
+    std::size_t tailSeen = 0;                        // consumer's copy of tail
+    alignas(64) std::atomic<std::size_t> tail{ 0 };  // producer writes
+    std::size_t headSeen = 0;                        // producer's copy of head
+};
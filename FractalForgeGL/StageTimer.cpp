@@ -0,0 +1,37 @@
+﻿#include "StageTimer.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <ctime>
+#endif
+
+const char* stageName(Stage s)
+{
+    static const char* names[NSTAGE] = { "render", "readback", "metrics", "evolve" };
+    return names[int(s)];
+}
+
+void StageTimes::add(const StageTimes& o)
+{
+    for (int k = 0; k < NSTAGE; ++k) {
+        wallMs[k] += o.wallMs[k];
+        cpuMs[k] += o.cpuMs[k];
+        calls[k] += o.calls[k];
+    }
+}
+
+double threadCpuMs()
+{
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user)) return 0.0;
+    auto ticks = [](const FILETIME& f) { return (double(f.dwHighDateTime) * 4294967296.0 + f.dwLowDateTime); };
+    return (ticks(kernel) + ticks(user)) * 1e-4;         // 100 ns units
+#else
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+#endif
+}
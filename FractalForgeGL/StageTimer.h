@@ -0,0 +1,48 @@
+﻿#pragma once
+#include <chrono>
+
+// ─── per-stage wall / CPU time ───────────────────────────────────────────────
+// Render: filling the buffer (GL: draw and wait for it; pipelined: submit);
+// Readback: counts to host memory (GL only); Metrics: measureFitness();
+// Evolve: NSGA-II select + breed. CPU time is the running thread's, so the
+// tile workers of a multi-threaded CpuMandelbrotRenderer are not in it.
+enum class Stage { Render, Readback, Metrics, Evolve };
+constexpr int NSTAGE = 4;
+
+const char* stageName(Stage s);
+
+struct StageTimes {
+    double    wallMs[NSTAGE] = {}, cpuMs[NSTAGE] = {};
+    long long calls[NSTAGE] = {};
+
+    void add(const StageTimes& o);
+    void clear() { *this = StageTimes(); }
+};
+
+double threadCpuMs();                            // CPU time of the calling thread
+
+// adds its lifetime to one stage of a sink; a null sink times nothing
+class ScopedStage {
+public:
+    ScopedStage(StageTimes* t, Stage s) : t(t), s(int(s))
+    {
+        if (!t) return;
+        wall0 = std::chrono::steady_clock::now();
+        cpu0 = threadCpuMs();
+    }
+    ~ScopedStage()
+    {
+        if (!t) return;
+        t->wallMs[s] += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall0).count();
+        t->cpuMs[s] += threadCpuMs() - cpu0;
+        ++t->calls[s];
+    }
+    ScopedStage(const ScopedStage&) = delete;
+    ScopedStage& operator=(const ScopedStage&) = delete;
+
+private:
+    StageTimes* t;
+    int s;
+    std::chrono::steady_clock::time_point wall0;
+    double cpu0 = 0;
+};
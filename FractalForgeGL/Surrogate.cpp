@@ -0,0 +1,209 @@
+﻿#include "Surrogate.h"
+#include <algorithm>
+#include <cmath>
+
+// ─── Gaussian process ────────────────────────────────────────────────────────
+double GaussianProcess::kernel(const double* a, const double* b, double l) const
+{
+    double d2 = 0;
+    for (int k = 0; k < dims; ++k) d2 += (a[k] - b[k]) * (a[k] - b[k]);
+    return std::exp(-0.5 * d2 / (l * l));
+}
+
+// in place, lower triangle; false if A is not positive definite
+bool GaussianProcess::cholesky(std::vector<double>& A, int n)
+{
+    for (int j = 0; j < n; ++j) {
+        double d = A[j * n + j];
+        for (int k = 0; k < j; ++k) d -= A[j * n + k] * A[j * n + k];
+        if (d <= 0) return false;
+        d = std::sqrt(d);
+        A[j * n + j] = d;
+        for (int i = j + 1; i < n; ++i) {
+            double s = A[i * n + j];
+            for (int k = 0; k < j; ++k) s -= A[i * n + k] * A[j * n + k];
+            A[i * n + j] = s / d;
+        }
+    }
+    return true;
+}
+
+void GaussianProcess::fit(const std::vector<double>& Xin, const std::vector<double>& y, int d,
+    bool search)
+{
+    dims = d;
+    const int m = (int)y.size();
+    n = 0;
+    if (m == 0) return;
+
+    double mean = 0, var = 0;
+    for (double v : y) mean += v;
+    mean /= m;
+    for (double v : y) var += (v - mean) * (v - mean);
+    yMean = mean;
+    yScale = (var > 0) ? std::sqrt(var / m) : 1.0;
+    std::vector<double> ys(m);
+    for (int i = 0; i < m; ++i) ys[i] = (y[i] - yMean) / yScale;
+
+    // grid search by log marginal likelihood (up to the constant)
+    K.resize(m * m); a.resize(m);
+    std::vector<double> lens{ len }, noises{ noise };
+    if (search) { lens = { 0.1, 0.2, 0.4, 0.8 }; noises = { 1e-4, 1e-2, 1e-1 }; }
+    double bestLml = -INFINITY;
+    for (double l : lens)
+        for (double s2 : noises) {
+            for (int i = 0; i < m; ++i)
+                for (int j = 0; j <= i; ++j)
+                    K[i * m + j] = kernel(&Xin[i * d], &Xin[j * d], l) + (i == j ? s2 : 0.0);
+            if (!cholesky(K, m)) continue;
+            for (int i = 0; i < m; ++i) {            // L z = y, Lᵀ a = z
+                double s = ys[i];
+                for (int k = 0; k < i; ++k) s -= K[i * m + k] * a[k];
+                a[i] = s / K[i * m + i];
+            }
+            double lml = 0;
+            for (int i = 0; i < m; ++i) lml -= 0.5 * a[i] * a[i] + std::log(K[i * m + i]);
+            if (lml <= bestLml) continue;
+            for (int i = m - 1; i >= 0; --i) {
+                double s = a[i];
+                for (int k = i + 1; k < m; ++k) s -= K[k * m + i] * a[k];
+                a[i] = s / K[i * m + i];
+            }
+            bestLml = lml; len = l; noise = s2;
+            L = K; alpha = a;
+        }
+    if (bestLml == -INFINITY) {                  // not positive definite: try the grid
+        if (!search) fit(Xin, y, d, true);
+        return;
+    }
+    X = Xin;
+    n = m;
+}
+
+void GaussianProcess::save(ByteWriter& out) const
+{
+    out.put(dims); out.put(n);
+    out.put(len); out.put(noise); out.put(yMean); out.put(yScale);
+    out.putVec(X); out.putVec(L); out.putVec(alpha);
+}
+
+void GaussianProcess::load(ByteReader& in)
+{
+    in.get(dims); in.get(n);
+    in.get(len); in.get(noise); in.get(yMean); in.get(yScale);
+    in.getVec(X); in.getVec(L); in.getVec(alpha);
+    if (n < 0 || X.size() != size_t(n) * dims || L.size() != size_t(n) * n || alpha.size() != size_t(n)) {
+        in.fail();
+        n = 0;
+    }
+}
+
+void GaussianProcess::predict(const double* x, double& mean, double& sd) const
+{
+    std::vector<double> k(n), v(n);
+    double mu = 0;
+    for (int i = 0; i < n; ++i) { k[i] = kernel(x, &X[i * dims], len); mu += k[i] * alpha[i]; }
+    double var = 1.0;                            // latent variance: 1 − vᵀv, L v = k
+    for (int i = 0; i < n; ++i) {
+        double s = k[i];
+        for (int j = 0; j < i; ++j) s -= L[i * n + j] * v[j];
+        v[i] = s / L[i * n + i];
+        var -= v[i] * v[i];
+    }
+    mean = yMean + yScale * mu;
+    sd = yScale * std::sqrt(std::max(var, 0.0));
+}
+
+// ─── surrogate ───────────────────────────────────────────────────────────────
+Surrogate::Surrogate(int minIter, int maxIter, int minRes, int maxRes, int maxSupersample,
+    int cap)
+    : logIter0(std::log2(double(minIter))), logIterSpan(std::log2(double(maxIter) / minIter)),
+    logRes0(std::log2(double(minRes))), logResSpan(std::log2(double(maxRes) / minRes)),
+    ssSpan(maxSupersample - 1), capacity(cap)
+{
+}
+
+void Surrogate::features(const Genome& g, double* f) const
+{
+    f[0] = logIterSpan > 0 ? (std::log2(double(g.maxIter)) - logIter0) / logIterSpan : 0.0;
+    f[1] = logResSpan > 0 ? (std::log2(double(g.res)) - logRes0) / logResSpan : 0.0;
+    f[2] = ssSpan > 0 ? (g.supersample - 1) / ssSpan : 0.0;
+    f[3] = g.interior ? 1.0 : 0.0;
+}
+
+void Surrogate::add(const Genome& g, const float* measured)
+{
+    auto it = index.find(g.key());
+    int r;
+    if (it != index.end()) r = it->second;
+    else if ((int)rows.size() < capacity) { r = (int)rows.size(); rows.emplace_back(); }
+    else {                                       // replace the oldest
+        r = int(std::min_element(rows.begin(), rows.end(),
+            [](const Row& a, const Row& b) { return a.seq < b.seq; }) - rows.begin());
+        index.erase(rows[r].g.key());
+    }
+    rows[r].g = g;
+    std::copy(measured, measured + NOUT, rows[r].y);
+    rows[r].seq = seq++;
+    index[g.key()] = r;
+    stale = true;
+    ++changed;
+}
+
+void Surrogate::clear()
+{
+    rows.clear(); index.clear();
+    for (auto& p : gp) p = GaussianProcess();
+    stale = false;
+    changed = 0;
+}
+
+void Surrogate::fit()
+{
+    if (!stale) return;
+    stale = false;
+    const int n = size();
+    const bool search = !gp[0].trained() || 4 * changed >= n;  // a quarter of it is new
+    if (search) changed = 0;
+    std::vector<double> X(n * NFEAT), y(n);
+    for (int i = 0; i < n; ++i) features(rows[i].g, &X[i * NFEAT]);
+    for (int k = 0; k < NOUT; ++k) {
+        for (int i = 0; i < n; ++i) y[i] = toModel(k, rows[i].y[k]);
+        gp[k].fit(X, y, NFEAT, search || !gp[k].trained());
+    }
+}
+
+void Surrogate::save(ByteWriter& out) const
+{
+    out.put(capacity); out.put(seq); out.put(stale); out.put(changed);
+    out.putVec(rows);
+    for (const auto& p : gp) p.save(out);
+}
+
+void Surrogate::load(ByteReader& in)
+{
+    int cap = 0;
+    in.get(cap);
+    if (cap != capacity) in.fail();
+    in.get(seq); in.get(stale); in.get(changed);
+    in.getVec(rows);
+    for (auto& p : gp) p.load(in);
+    index.clear();
+    for (int r = 0; r < size(); ++r) index[rows[r].g.key()] = r;
+    if (!in.ok()) clear();
+}
+
+SurrogatePrediction Surrogate::predict(const Genome& g, float kappa) const
+{
+    double f[NFEAT];
+    features(g, f);
+    SurrogatePrediction p;
+    for (int k = 0; k < NOUT; ++k) {
+        double mean = 0, sd = 0;
+        if (gp[k].trained()) gp[k].predict(f, mean, sd);
+        p.mean[k] = fromModel(k, mean);
+        p.lower[k] = fromModel(k, mean - kappa * sd);
+        p.upper[k] = fromModel(k, mean + kappa * sd);
+    }
+    return p;
+}
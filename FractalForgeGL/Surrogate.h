@@ -0,0 +1,76 @@
+﻿#pragma once
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "RenderBackend.h"
+#include "Snapshot.h"
+
+// ─── Gaussian-process regression, one output ─────────────────────────────────
+// RBF kernel on feature rows of `dims` floats in [0,1]; targets are
+// standardised. With `search`, fit() picks the length scale and noise from a
+// small grid by log marginal likelihood (one Cholesky each); otherwise it
+// refits at the current ones (one Cholesky).
+class GaussianProcess {
+public:
+    void fit(const std::vector<double>& X, const std::vector<double>& y, int dims, bool search);
+    bool trained() const { return n > 0; }
+    void predict(const double* x, double& mean, double& sd) const;
+
+    // fitted state as is (no refit on load, so predictions repeat exactly)
+    void save(ByteWriter& out) const;
+    void load(ByteReader& in);
+
+private:
+    int dims = 0, n = 0;
+    double len = 0.3, noise = 1e-2, yMean = 0, yScale = 1;
+    std::vector<double> X, L, alpha;             // inputs, Cholesky factor, K⁻¹y
+    std::vector<double> K, a;                    // fit() scratch
+
+    double kernel(const double* a, const double* b, double l) const;
+    static bool cholesky(std::vector<double>& A, int n);
+};
+
+// ─── per-objective surrogate of the fitness of a genome ──────────────────────
+// Trained on every distinct genome evaluated at the current view (latest
+// result wins, oldest dropped beyond `capacity`); one GP per measured value
+// (fpsErr, gpuMs, boundary, density), the first three on a log1p scale since
+// they span orders of magnitude.
+struct SurrogatePrediction {
+    float mean[4], lower[4], upper[4];           // measured values, mean ∓ κσ
+};
+
+class Surrogate {
+public:
+    static constexpr int NOUT = 4, NFEAT = 4;
+
+    // feature scaling from the genome's search box
+    Surrogate(int minIter, int maxIter, int minRes, int maxRes, int maxSupersample,
+        int capacity = 192);
+
+    void add(const Genome& g, const float* measured);  // marks the model stale
+    void clear();                                      // e.g. the view moved
+    int  size() const { return (int)rows.size(); }
+
+    void fit();                                        // no-op unless stale
+    SurrogatePrediction predict(const Genome& g, float kappa) const;
+
+    void save(ByteWriter& out) const;            // training set and fitted GPs
+    void load(ByteReader& in);
+
+private:
+    struct Row { Genome g; float y[NOUT]; std::uint64_t seq; };
+
+    double logIter0, logIterSpan, logRes0, logResSpan, ssSpan;
+    int capacity;
+    std::uint64_t seq = 0;
+    bool stale = false;
+    int  changed = 0;                                  // adds since the last grid search
+    std::vector<Row> rows;
+    std::unordered_map<std::uint64_t, int> index;      // genome key → row
+    GaussianProcess gp[NOUT];
+
+    void features(const Genome& g, double* f) const;
+    static double toModel(int k, float v) { return k < 3 ? std::log1p(double(v)) : double(v); }
+    static float  fromModel(int k, double v) { return float(k < 3 ? std::expm1(v) : v); }
+};
@@ -0,0 +1,68 @@
+﻿#include "ThreadPool.h"
+#include <algorithm>
+
+// ─── ctor/dtor ───────────────────────────────────────────────────────────────
+ThreadPool::ThreadPool(int threads)
+    : nThreads(threads > 0 ? threads
+        : std::max(1, (int)std::thread::hardware_concurrency())),
+    ranges(new Range[nThreads])
+{
+    for (int i = 1; i < nThreads; ++i)
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+ThreadPool::~ThreadPool()
+{
+    { std::lock_guard<std::mutex> lk(m); quit = true; }
+    wake.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+// ─── scheduling ──────────────────────────────────────────────────────────────
+void ThreadPool::parallelFor(int count, const std::function<void(int, int)>& fn)
+{
+    if (count <= 0) return;
+    if (nThreads == 1) { for (int i = 0; i < count; ++i) fn(i, 0); return; }
+
+    for (int w = 0; w < nThreads; ++w) {
+        ranges[w].next.store(int((long long)count * w / nThreads), std::memory_order_relaxed);
+        ranges[w].end = int((long long)count * (w + 1) / nThreads);
+    }
+    {
+        std::lock_guard<std::mutex> lk(m);
+        job = &fn; ++jobId; pending = nThreads - 1;
+    }
+    wake.notify_all();
+
+    drain(0);
+
+    std::unique_lock<std::mutex> lk(m);
+    done.wait(lk, [this] { return pending == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::drain(int id)
+{
+    for (int k = 0; k < nThreads; ++k) {             // own range first, then steal
+        Range& r = ranges[(id + k) % nThreads];
+        for (int t; (t = r.next.fetch_add(1, std::memory_order_relaxed)) < r.end; )
+            (*job)(t, id);
+    }
+}
+
+void ThreadPool::workerLoop(int id)
+{
+    unsigned seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lk(m);
+            wake.wait(lk, [&] { return quit || jobId != seen; });
+            if (quit) return;
+            seen = jobId;
+        }
+        drain(id);
+        {
+            std::lock_guard<std::mutex> lk(m);
+            if (--pending == 0) done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,45 @@
+﻿#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ─── fixed worker pool with per-worker work stealing ─────────────────────────
+// parallelFor() splits [0,count) into one contiguous range per worker; a worker
+// drains its own range first and then steals single tasks from the others, so
+// uneven tasks (interior tiles cost ~maxIter, exterior ones a few steps) still
+// keep every core busy. The calling thread takes part as worker 0.
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads = 0);        // 0 → hardware_concurrency
+    ~ThreadPool();
+
+    int size() const { return nThreads; }
+
+    // fn(task, worker) for every task; blocks until all are done.
+    // Not re-entrant: call from one thread at a time.
+    void parallelFor(int count, const std::function<void(int, int)>& fn);
+
+private:
+    struct alignas(64) Range {
+        std::atomic<int> next{ 0 };
+        int end = 0;
+    };
+
+    int nThreads;
+    std::vector<std::thread> workers;
+    std::unique_ptr<Range[]> ranges;
+
+    std::mutex m;
+    std::condition_variable wake, done;
+    const std::function<void(int, int)>* job = nullptr;
+    unsigned jobId = 0;
+    int  pending = 0;
+    bool quit = false;
+
+    void workerLoop(int id);
+    void drain(int id);
+};
@@ -0,0 +1,266 @@
+﻿#include "TileCache.h"
+#include "CpuMandelbrotRenderer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static constexpr std::size_t TILE_BYTES = sizeof(std::uint16_t) * TileCache::TILE * TileCache::TILE;
+
+// floor(v / 2^k), also for negative v
+static std::int64_t floorShift(std::int64_t v, int k) { return v >= 0 ? v >> k : ~(~v >> k); }
+
+// level whose pixels are nearest the screen's (within a factor √2)
+static int levelFor(double zoom, float aspect, int w, int h)
+{
+    const double pix = std::min(zoom * aspect / w, zoom / h);
+    const long   l = std::lround(std::log2(TileCache::ROOT / TileCache::TILE / pix));
+    return (int)std::clamp(l, 0L, (long)TileCache::MAX_LEVEL);
+}
+
+// level pixels per unit of the plane
+static double pixelScale(int level) { return std::ldexp(TileCache::TILE / TileCache::ROOT, level); }
+
+// nearest a point (in tile units) first
+template <class It>
+static void sortByDistance(It begin, It end, double cx, double cy)
+{
+    auto d2 = [cx, cy](const TileKey& k) {
+        double x = k.tx + 0.5 - cx, y = k.ty + 0.5 - cy;
+        return x * x + y * y;
+    };
+    std::sort(begin, end, [&d2](const TileKey& a, const TileKey& b) { return d2(a) < d2(b); });
+}
+
+// ─── key ─────────────────────────────────────────────────────────────────────
+int TileCache::keyIter(int maxIter)
+{
+    int k = 64;
+    while (k < maxIter && k < RenderBackend::MAX_ITER) k *= 2;
+    return std::min(k, RenderBackend::MAX_ITER);
+}
+
+std::size_t TileCache::KeyHash::operator()(const TileKey& k) const
+{
+    std::uint64_t h = 1469598103934665603ull;      // FNV-1a over the fields
+    for (std::uint64_t v : { std::uint64_t(k.level) << 32 | std::uint32_t(k.maxIter),
+                             std::uint64_t(k.tx), std::uint64_t(k.ty) })
+        h = (h ^ v) * 1099511628211ull;
+    return (std::size_t)h;
+}
+
+// ─── arena ───────────────────────────────────────────────────────────────────
+int TileCache::Arena::take()
+{
+    if (next == capacity) return -1;
+    if (next == reserved())
+        chunks.emplace_back(new std::uint16_t[std::size_t(CHUNK) * TILE * TILE]);
+    return next++;
+}
+
+// ─── ctor/dtor ───────────────────────────────────────────────────────────────
+TileCache::TileCache(std::size_t budget, int threads, bool interior, bool subdivide)
+    : arena(std::max(1, int(budget / TILE_BYTES / CHUNK)) * CHUNK)
+{
+    slots.resize(std::max(1, int(budget / TILE_BYTES / CHUNK)) * CHUNK);
+    st.bytesBudget = slots.size() * TILE_BYTES;
+    for (int i = 0; i < std::max(1, threads); ++i)
+        workers.emplace_back(&TileCache::workerLoop, this, interior, subdivide);
+}
+TileCache::~TileCache()
+{
+    { std::lock_guard<std::mutex> lk(m); quit = true; }
+    wake.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+// ─── LRU ─────────────────────────────────────────────────────────────────────
+void TileCache::unlink(int s)
+{
+    Slot& n = slots[s];
+    (n.prev >= 0 ? slots[n.prev].next : head) = n.next;
+    (n.next >= 0 ? slots[n.next].prev : tail) = n.prev;
+    n.prev = n.next = -1;
+}
+void TileCache::pushFront(int s)
+{
+    slots[s].next = head;
+    if (head >= 0) slots[head].prev = s;
+    head = s;
+    if (tail < 0) tail = s;
+}
+
+const std::uint16_t* TileCache::find(const TileKey& k)
+{
+    auto it = index.find(k);
+    if (it == index.end()) return nullptr;
+    if (it->second != head) { unlink(it->second); pushFront(it->second); }
+    return arena.at(it->second);
+}
+
+std::uint16_t* TileCache::insert(const TileKey& k)
+{
+    int s = arena.take();
+    if (s < 0) {                                 // full: reuse the stalest slot
+        s = tail;
+        unlink(s);
+        index.erase(slots[s].key);
+        ++st.evicted;
+    }
+    slots[s].key = k;
+    pushFront(s);
+    index[k] = s;
+    return arena.at(s);
+}
+
+// ─── background rendering ────────────────────────────────────────────────────
+void TileCache::workerLoop(bool interior, bool subdivide)
+{
+    CpuMandelbrotRenderer r(TILE, TILE, 1);      // square: aspect 1
+    r.setResolution(TILE, TILE);
+    r.setInteriorCheck(interior);
+    r.setSubdivision(subdivide);
+
+    std::unique_lock<std::mutex> lk(m);
+    for (;;) {
+        wake.wait(lk, [this] { return quit || !demand.empty() || !ahead.empty(); });
+        if (quit) return;
+        const bool pre = demand.empty();
+        std::deque<TileKey>& q = pre ? ahead : demand;
+        const TileKey k = q.front();
+        q.pop_front();
+        if (index.count(k) || busy.count(k)) continue;
+        busy.insert(k);
+        lk.unlock();
+
+        // tile pixel x samples (tx + (x+0.5)/TILE)·side, as compose() reads it
+        const double side = std::ldexp(ROOT, -k.level);
+        DeepView v;
+        v.cx = dd((double(k.tx) + 0.5) * side);
+        v.cy = dd((double(k.ty) + 0.5) * side);
+        v.zoom = side;
+        r.setMaxIter(k.maxIter);
+        r.setView(v);
+        r.renderOffscreen();
+
+        lk.lock();
+        busy.erase(k);
+        std::memcpy(insert(k), r.iterationPtr(), TILE_BYTES);
+        ++st.rendered;
+        if (pre) ++st.prefetched;
+    }
+}
+
+// tiles of the view one step further along the last move, nearest its centre
+// first: a level finer/coarser after a zoom, half a screen on after a pan
+void TileCache::prefetch(const DeepView& v, float aspect, int maxIter, int w, int h)
+{
+    ahead.clear();
+    DeepView next = v;
+    if (v.zoom < last.v.zoom) next.zoom = v.zoom / 2.0;
+    else if (v.zoom > last.v.zoom) next.zoom = v.zoom * 2.0;
+    else {
+        const double dx = double(v.cx - last.v.cx), dy = double(v.cy - last.v.cy);
+        if (dx == 0.0 && dy == 0.0) return;      // only maxIter or the window changed
+        next.cx = v.cx + dd(((dx > 0) - (dx < 0)) * 0.5 * v.zoom * aspect);
+        next.cy = v.cy + dd(((dy > 0) - (dy < 0)) * 0.5 * v.zoom);
+    }
+
+    const int    L = levelFor(next.zoom, aspect, w, h);
+    const double s = pixelScale(L) / TILE;       // tiles per unit
+    const double cx = double(next.cx) * s, cy = double(next.cy) * s;
+    const double hw = 0.5 * next.zoom * aspect * s, hh = 0.5 * next.zoom * s;
+    for (auto ty = (std::int64_t)std::floor(cy - hh); ty <= (std::int64_t)std::floor(cy + hh); ++ty)
+        for (auto tx = (std::int64_t)std::floor(cx - hw); tx <= (std::int64_t)std::floor(cx + hw); ++tx) {
+            TileKey k{ L, maxIter, tx, ty };
+            if (!index.count(k) && !busy.count(k)) ahead.push_back(k);
+        }
+    sortByDistance(ahead.begin(), ahead.end(), cx, cy);
+}
+
+// ─── compose ─────────────────────────────────────────────────────────────────
+bool TileCache::compose(const DeepView& v, float aspect, int maxIter, int w, int h,
+    std::vector<std::uint16_t>& counts)
+{
+    maxIter = keyIter(maxIter);
+    std::lock_guard<std::mutex> lk(m);
+    const bool moved = !(v.cx == last.v.cx && v.cy == last.v.cy && v.zoom == last.v.zoom
+        && aspect == last.aspect && maxIter == last.maxIter && w == last.w && h == last.h);
+    if (!moved && last.complete) return true;
+
+    // level pixel under every screen pixel centre
+    const int    L = levelFor(v.zoom, aspect, w, h);
+    const double scale = pixelScale(L), ox = double(v.cx), oy = double(v.cy);
+    colPx.resize(w); rowPx.resize(h);
+    for (int x = 0; x < w; ++x)
+        colPx[x] = (std::int64_t)std::floor((((x + 0.5) / w - 0.5) * v.zoom * aspect + ox) * scale);
+    for (int y = 0; y < h; ++y)
+        rowPx[y] = (std::int64_t)std::floor((((y + 0.5) / h - 0.5) * v.zoom + oy) * scale);
+    const std::int64_t tx0 = floorShift(colPx[0], TILE_SHIFT), ty0 = floorShift(rowPx[0], TILE_SHIFT);
+    const int nx = int(floorShift(colPx[w - 1], TILE_SHIFT) - tx0) + 1;
+    const int ny = int(floorShift(rowPx[h - 1], TILE_SHIFT) - ty0) + 1;
+    runEnd.clear();                              // first column of each next tile
+    for (int x = 1; x < w; ++x)
+        if (floorShift(colPx[x], TILE_SHIFT) != floorShift(colPx[x - 1], TILE_SHIFT)) runEnd.push_back(x);
+
+    // per tile of the view: its counts, the same tile keyed at half or twice
+    // maxIter (drawn as is; the palette clamps), or those of the nearest
+    // cached ancestor `up` levels higher, whose pixel (x>>up, y>>up) covers (x, y)
+    struct Source {
+        const std::uint16_t* p;
+        int up;
+        std::int64_t x0, y0;                     // its first pixel at its level
+    };
+    std::vector<Source> src(std::size_t(nx) * ny);
+    std::vector<TileKey> missing;
+    bool complete = true;
+    for (int j = 0; j < ny; ++j)
+        for (int i = 0; i < nx; ++i) {
+            const TileKey k{ L, maxIter, tx0 + i, ty0 + j };
+            Source& s = src[std::size_t(j) * nx + i];
+            s = { find(k), 0, k.tx * TILE, k.ty * TILE };
+            if (moved) ++(s.p ? st.hits : st.misses);
+            if (s.p) continue;
+            complete = false;
+            if (!busy.count(k)) missing.push_back(k);
+            for (int alt : { maxIter / 2, maxIter * 2 })
+                if (!s.p) s.p = find({ L, std::min(alt, RenderBackend::MAX_ITER), k.tx, k.ty });
+            for (int up = 1; up <= L && !s.p; ++up) {
+                const TileKey a{ L - up, maxIter, floorShift(k.tx, up), floorShift(k.ty, up) };
+                if (const std::uint16_t* p = find(a)) s = { p, up, a.tx * TILE, a.ty * TILE };
+            }
+        }
+
+    // row by row, one run of screen columns per tile column
+    counts.resize(std::size_t(w) * h);
+    for (int y = 0; y < h; ++y) {
+        const std::int64_t gy = rowPx[y];
+        const Source* row = &src[std::size_t(floorShift(gy, TILE_SHIFT) - ty0) * nx];
+        std::uint16_t* out = &counts[std::size_t(y) * w];
+        for (int i = 0, x = 0; i < nx; ++i) {
+            const Source& s = row[i];
+            const int end = i + 1 < nx ? runEnd[i] : w;
+            if (!s.p) { std::fill(out + x, out + end, std::uint16_t(0)); x = end; continue; }
+            const std::uint16_t* line = s.p + (floorShift(gy, s.up) - s.y0) * TILE;
+            for (; x < end; ++x) out[x] = line[floorShift(colPx[x], s.up) - s.x0];
+        }
+    }
+
+    // centre tiles first; the prefetch queue follows the camera's last move
+    sortByDistance(missing.begin(), missing.end(), ox * scale / TILE, oy * scale / TILE);
+    demand.assign(missing.begin(), missing.end());
+    if (moved && last.w) prefetch(v, aspect, maxIter, w, h);
+    if (!demand.empty() || !ahead.empty()) wake.notify_all();
+
+    last = { v, aspect, maxIter, w, h, complete };
+    return last.complete;
+}
+
+TileStats TileCache::stats() const
+{
+    std::lock_guard<std::mutex> lk(m);
+    TileStats s = st;
+    s.tiles = index.size();
+    s.bytesUsed = std::size_t(arena.used()) * TILE_BYTES;
+    s.bytesReserved = std::size_t(arena.reserved()) * TILE_BYTES;
+    return s;
+}
@@ -0,0 +1,119 @@
+﻿#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "RenderBackend.h"
+
+// ─── quadtree tile store for the onscreen view (--tiles) ─────────────────────
+// The plane is cut into TILE×TILE-pixel tiles of raw counts; a level-L tile
+// is ROOT/2^L wide, so its four children at L+1 cover it at twice the
+// resolution. compose() draws a view from the level whose pixels are closest
+// to the screen's, resampling nearest, so zooming back out or panning back
+// over a seen region costs no iterations. Tiles are rendered on background
+// threads (one single-threaded CPU renderer each): first those the current
+// view lacks, then prefetch along the last pan/zoom direction. While a tile
+// is missing, the same tile at the neighbouring maxIter key stands in, else
+// its nearest cached ancestor, magnified.
+// maxIter is keyed rounded up to a power of two (keyIter()): the evolved
+// gene changes with every new best genome, the key only when it doubles.
+// Tiles live in an arena of fixed-size slots, grown chunk-wise up to the
+// byte budget; once it is full the least recently drawn tile is evicted.
+// Float kernel only: deep zooms are beyond what tile corners resolve.
+
+struct TileKey {
+    int level = 0, maxIter = 0;
+    std::int64_t tx = 0, ty = 0;                 // lower-left corner / tile side
+    bool operator==(const TileKey& o) const {
+        return level == o.level && maxIter == o.maxIter && tx == o.tx && ty == o.ty;
+    }
+};
+
+// tile lookups per new view (not per redraw), renders and memory
+struct TileStats {
+    std::uint64_t hits = 0, misses = 0;
+    std::uint64_t rendered = 0, prefetched = 0;  // prefetched: part of rendered
+    std::uint64_t evicted = 0;
+    std::size_t   tiles = 0, bytesUsed = 0, bytesReserved = 0, bytesBudget = 0;
+};
+
+class TileCache {
+public:
+    static constexpr int    TILE = 128;
+    static constexpr int    TILE_SHIFT = 7;      // log2(TILE)
+    static constexpr int    MAX_LEVEL = 48;
+    static constexpr double ROOT = 4.0;          // level-0 tile side; tiles start at 0
+    static constexpr int    CHUNK = 64;          // arena growth, in tiles
+
+    // budget: tile memory in bytes (a few screens at least); interior and
+    // subdivide as for CpuMandelbrotRenderer
+    TileCache(std::size_t budget, int threads, bool interior, bool subdivide);
+    ~TileCache();
+    TileCache(const TileCache&) = delete;
+    TileCache& operator=(const TileCache&) = delete;
+
+    // w×h counts of view v at keyIter(maxIter) iterations (aspect as the
+    // renderers' winW/winH, row 0 at the bottom); true once no tile of it
+    // is a stand-in
+    bool compose(const DeepView& v, float aspect, int maxIter, int w, int h,
+        std::vector<std::uint16_t>& counts);
+
+    TileStats stats() const;
+
+    static int keyIter(int maxIter);             // what tiles are rendered (and drawn) with
+
+private:
+    struct KeyHash {
+        std::size_t operator()(const TileKey& k) const;
+    };
+    // fixed-size tile buffers, bump-allocated in chunks of CHUNK; never freed
+    // one by one, an evicted tile's slot is reused
+    class Arena {
+    public:
+        explicit Arena(int capacity) : capacity(capacity) {}
+        int  take();                             // next unused slot, -1 when full
+        std::uint16_t* at(int slot) { return chunks[slot / CHUNK].get() + std::size_t(slot % CHUNK) * TILE * TILE; }
+        int  used() const { return next; }
+        int  reserved() const { return int(chunks.size()) * CHUNK; }
+    private:
+        int capacity, next = 0;
+        std::vector<std::unique_ptr<std::uint16_t[]>> chunks;
+    };
+    struct Slot {                                // LRU list node, by arena slot
+        TileKey key;
+        int prev = -1, next = -1;
+    };
+    struct Frame {                               // what compose() last drew
+        DeepView v;
+        float aspect = 0.0f;
+        int   maxIter = 0, w = 0, h = 0;
+        bool  complete = false;
+    };
+
+    mutable std::mutex m;
+    std::condition_variable wake;
+    Arena arena;
+    std::vector<Slot> slots;
+    int head = -1, tail = -1;                    // most / least recently drawn
+    std::unordered_map<TileKey, int, KeyHash> index;
+    std::unordered_set<TileKey, KeyHash> busy;   // being rendered
+    std::deque<TileKey> demand, ahead;           // missing from the view / prefetch
+    Frame last;
+    std::vector<std::int64_t> colPx, rowPx;      // per screen column/row: level pixel
+    std::vector<int> runEnd;                     // compose(): columns where a tile ends
+    TileStats st;
+    bool quit = false;
+    std::vector<std::thread> workers;
+
+    void workerLoop(bool interior, bool subdivide);
+    const std::uint16_t* find(const TileKey& k);           // and mark it recently drawn
+    std::uint16_t* insert(const TileKey& k);               // evicts when full
+    void unlink(int s);
+    void pushFront(int s);
+    void prefetch(const DeepView& v, float aspect, int maxIter, int w, int h);
+};
@@ -1,46 +1,744 @@
 ﻿// ─────────────────────────────────────────────────────────────────────────────
 //  Mandelbrot + NSGA‑II  — all‑tweakables‑up‑front version
 //  Build (Linux/macOS):
-//      g++ -std=c++17 -O2 main.cpp MandelbrotRenderer.cpp NSGAII.cpp glad.c \
+//      g++ -std=c++17 -O2 -ffp-contract=off main.cpp MandelbrotRenderer.cpp \
+//          CpuMandelbrotRenderer.cpp ThreadPool.cpp BatchEvaluator.cpp \
+//          FitnessCache.cpp FitnessMetrics.cpp Simd.cpp HeadlessGL.cpp DeepZoom.cpp \
+//          NSGAII.cpp ParetoSort.cpp Surrogate.cpp MultiFidelity.cpp Logger.cpp \
+//          Snapshot.cpp StageTimer.cpp RemoteEvaluator.cpp TileCache.cpp glad.c \
 //          -lglfw -ldl -lGL -pthread -o MandelbrotNSGA
+//      (add -DFF_HAVE_EGL -lEGL for window-less GPU runs, e.g. on Mesa llvmpipe)
 //  Build (MSVC):
-//      cl /std:c++17 /O2 main.cpp MandelbrotRenderer.cpp NSGAII.cpp glad.c\
-//          glfw3.lib opengl32.lib user32.lib gdi32.lib shell32.lib
+//      cl /std:c++17 /O2 main.cpp MandelbrotRenderer.cpp CpuMandelbrotRenderer.cpp\
+//          ThreadPool.cpp BatchEvaluator.cpp FitnessCache.cpp FitnessMetrics.cpp\
+//          Simd.cpp HeadlessGL.cpp DeepZoom.cpp NSGAII.cpp ParetoSort.cpp\
+//          Surrogate.cpp MultiFidelity.cpp Logger.cpp Snapshot.cpp\
+//          StageTimer.cpp RemoteEvaluator.cpp TileCache.cpp glad.c\
+//          glfw3.lib opengl32.lib user32.lib gdi32.lib shell32.lib ws2_32.lib
+//  Run:
+//      MandelbrotNSGA [--cpu [threads]] [--no-cache] [--deep] [--view cx cy zoom]
+//                     [--no-interior] [--subdivide] [--progressive] [--tiles] [--banded]
+//                     [--res R] [--ss S] [--surrogate [explore]]
+//                     [--log file] [--csv file] [--checkpoint file [every]]
+//                     [--resume file]
+//          --checkpoint: snapshot the run every `every` generations (default
+//          CFG::snapshotEvery), written by a background thread; --resume:
+//          continue one with its seed, view and search options (and keep
+//          snapshotting to it at its interval unless --checkpoint says
+//          otherwise);
+//          --log: binary run log (default CFG::logFile), written by a
+//          background thread; --csv: also convert it to CSV after the run;
+//          --cpu: fitness renders on the CPU; --no-cache: re-render duplicates;
+//          --no-interior: keep the interior-check gene off (timing baseline);
+//          --res: pin the fitness buffer to R² instead of evolving it;
+//          --ss: largest supersampling factor the genome may pick (1: none);
+//          --surrogate: render only children a GP model expects to reach the
+//          front, plus an `explore` fraction of the rest (CSV: PRED rows =
+//          predictions for rendered children, SKIP = children not rendered,
+//          SURR,gen,rendered,skipped,4× mean relative error,model size);
+//          --subdivide: Mariani–Silver fill in CPU renders (fitness + preview);
+//          --progressive: onscreen view rendered coarse-to-fine on the CPU,
+//          coloured by whole counts;
+//          --tiles: onscreen view assembled from cached CPU tiles (quadtree,
+//          LRU, prefetch along the last move), so revisited views need no
+//          rendering; whole counts, above CFG::deepZoomBelow only;
+//          --banded: colour the GPU view by whole counts too, instead of the
+//          smooth (continuous) iteration count;
+//          --deep: perturbation kernel at any zoom (automatic below
+//          CFG::deepZoomBelow); cx/cy are read to ~32 digits
+//      MandelbrotNSGA --headless [--gens N] [--seed S] [--view cx cy zoom]
+//                     [--pop P] [--threads T] [--serial] [--gpu [depth]]
+//                     [--log file] [--csv file] [--subdivide] [--archive] [--surrogate [explore]]
+//                     [--fidelity [keep]] [--checkpoint file [every]] [--resume file]
+//                     [--coordinator port [--bind addr]]
+//          no window, no vsync: whole generations back to back on the CPU,
+//          T individuals at a time (--serial: one at a time, T tile threads;
+//          --gpu: GL renderer in a hidden context, `depth` frames in flight;
+//          --archive: log the all-time Pareto set as ARCH rows at the end;
+//          --resume: runs on to --gens N in total;
+//          --fidelity: children rendered at 64², the best `keep` of them at
+//          256², the best `keep` of those at their own res (successive
+//          halving); the rest are dropped. CSV: FIDL,gen,level,rendered,
+//          4× Spearman ρ vs. the next level,promoted,side;
+//          --coordinator: jobs go to --worker processes that connect to
+//          this port over TCP, instead of local threads; it listens on
+//          CFG::coordinatorBind (this host only) unless --bind names an
+//          interface address, 0.0.0.0 for all; no authentication, so
+//          only on a trusted network)
+//      MandelbrotNSGA --worker host port [--threads T]
+//          render jobs for a --coordinator run on T threads until it ends;
+//          same build on every node, trusted network only
+//      MandelbrotNSGA --log-to-csv log.fflog out.csv
+//          a run log as CSV (tag,gen,idx,maxIter,4 objectives,rank,res,...)
+//      MandelbrotNSGA --bench [--reps R] [--threads T] [--subdivide]
+//                     [--baseline file] [--save-baseline file]
+//          fixed scenes (full set, seahorse valley, deep minibrot, all
+//          interior) × maxIter × res on the CPU renderer: stage times,
+//          pixels/s, iterations/s, evaluations/s (mean ± CV) and NSGA-II
+//          select+breed; exits 1 if a case's median is slower than the
+//          baseline's by more than CFG::benchTolerance and 2× their CV
+//      MandelbrotNSGA --self-test [--threads T]
+//          exactness checks on the --bench scenes: every SIMD span kernel
+//          against the scalar one, pixel for pixel, and the SIMD pixel
+//          statistics (edges, Σp, Σp²) against the scalar pass, and
+//          --tiles views composed from the tile cache against a direct
+//          render; exits 1 on a mismatch
+//      MandelbrotNSGA --bench-sort [--seed S]
+//          ranking engine vs. the textbook O(M·N²) sort over population sizes
 // ─────────────────────────────────────────────────────────────────────────────
 #include "MandelbrotRenderer.h"
+#include "HeadlessGL.h"
+#include "CpuMandelbrotRenderer.h"
+#include "BatchEvaluator.h"
+#include "FitnessCache.h"
+#include "MultiFidelity.h"
 #include "NSGAII.h"
 #include "Logger.h"
+#include "Snapshot.h"
+#include "RemoteEvaluator.h"
+#include "TileCache.h"
+#include <algorithm>
 #include <iostream>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
 
 // ─────────── 1. ALL PARAMETERS IN ONE PLACE ─────────────────────────────────
 namespace CFG {
     // Window / view
     constexpr int   winW = 1280;
     constexpr int   winH = 720;
-    constexpr float panSpeed = 0.004f;     // relative to zoom
+    constexpr float panSpeed = 0.004f;     // relative to zoom, whole pixels
     constexpr float zoomFactor = 1.07f;
+    constexpr double deepZoomBelow = 1e-5;   // float runs out → perturbation
+    constexpr bool  smoothColour = true;     // onscreen: continuous iteration count
 
-    // Evolution
+    // Evolution: (μ+λ) with μ = λ = popSize
     constexpr int   popSize = 48;
     constexpr int   minIterLOD = 128;
     constexpr int   maxIterLOD = 20000;
-    constexpr float mutateProb = 0.9f;       // (inside NSGAII::evolve)
-    constexpr int   mutateDelta = 256;
+    constexpr float crossoverProb = 0.9f;    // SBX, per pair
+    constexpr float crossoverEta = 15.0f;
+    constexpr float mutateProb = 0.25f;      // polynomial, per gene (1/genes)
+    constexpr float mutateEta = 20.0f;
+
+    // --surrogate: GP pre-screening of children
+    constexpr float surrogateExplore = 0.1f;  // unpromising children rendered anyway
+    constexpr float surrogateKappa = 1.0f;    // optimism, in predicted std. deviations
+    constexpr int   surrogateMinTrain = 16;   // distinct genomes before screening starts
+    constexpr int   surrogateCapacity = 192;  // most recent distinct genomes modelled
+
+    // --fidelity: successive halving over fitness-buffer sides, then the
+    // genome's own buffer for what is left
+    constexpr int   fidelityLevels[] = { 64, 256 };
+    constexpr float fidelityKeep = 0.5f;      // promoted fraction per level
+
+    // Headless batch runs (--headless)
+    constexpr int   headlessGens = 100;
+    constexpr int   gpuPipeline = 3;          // frames in flight for --gpu
+
+    // --coordinator / --worker: evaluation spread over processes via TCP
+    constexpr const char* coordinatorBind = "127.0.0.1"; // local only; --bind for a rack
+    constexpr int   remoteBatchPerThread = 2; // jobs per message, per worker thread
+    constexpr int   heartbeatMs = 500;        // worker → coordinator, busy or idle
+    constexpr int   workerSilentMs = 5000;    // no message this long: worker dropped
+    constexpr int   batchLateMs = 30000;      // batch out this long: sent again elsewhere
+    constexpr int   workerRetrySec = 30;      // worker: how long to keep reconnecting
+
+    // --progressive: CPU time per frame spent refining the onscreen view
+    constexpr float frameBudgetMs = 10.0f;
+
+    // --tiles: memory for cached count tiles (32 KB each), background renderers
+    constexpr int   tileCacheMB = 256;
+    constexpr int   tileThreads = 2;
 
     // Performance target
     constexpr float targetFPS = 60.0f;
+    constexpr bool  interiorCheck = true;     // allow the cardioid/bulb + periodicity gene
+
+    // Off‑screen fitness buffer: the genome picks res² (powers of two) and a
+    // supersampling factor; res·supersample never exceeds evalMaxSide
+    constexpr int   evalMinRes = 64;
+    constexpr int   evalMaxRes = 1024;
+    constexpr int   maxSupersample = 4;
+    constexpr int   evalMaxSide = 1024;
+    constexpr int   minResLimit = 8;          // what --res accepts
+    constexpr int   maxResLimit = 4096;
+
+    // CPU backend (--cpu); 0 → one thread per core
+    constexpr int   cpuThreads = 0;
+
+    // Fitness cache: view grid in fractions of a fitness-buffer pixel
+    constexpr float cacheQuantum = 0.25f;
+
+    // Run log: binary, written off the render thread (--csv converts it)
+    constexpr const char* logFile = "run_log.fflog";
+    constexpr int   logRing = 1 << 14;        // rows buffered before row() waits
 
-    // Off‑screen fitness buffer (increase to raise GPU cost & metric fidelity)
-    constexpr int   evalW = 1024;
-    constexpr int   evalH = 1024;
+    // Snapshots (--checkpoint / --resume): every N generations and at the end
+    constexpr int   snapshotEvery = 10;
 
-    // CSV output
-    constexpr const char* csvFile = "run_log.csv";
+    // --bench-sort: largest population the O(M·N²) reference is timed on
+    constexpr int   benchSortRefMax = 16384;
+
+    // --bench: every scene at every maxIter × res, timed benchReps times
+    constexpr int   benchReps = 5;
+    constexpr int   benchIters[] = { 256, 1024, 4096 };
+    constexpr int   benchRes[] = { 128, 256, 512 };
+    constexpr float benchTolerance = 0.10f;  // slower than the baseline by more (and by more
+                                             // than 2× the combined CV): regression
 }
 // ─────────────────────────────────────────────────────────────────────────────
 
-int main() {
+// ─── command line ────────────────────────────────────────────────────────────
+struct Options {
+    bool     headless = false, useCpu = false, serial = false, cache = true, gpu = false;
+    int      cpuThreads = CFG::cpuThreads, pipeline = CFG::gpuPipeline;
+    int      gens = CFG::headlessGens, popSize = CFG::popSize;
+    unsigned seed = std::random_device{}();
+    bool     deep = false, interior = CFG::interiorCheck;
+    bool     subdivide = false, progressive = false, tiles = false, smooth = CFG::smoothColour;
+    bool     archive = false, benchSort = false, bench = false, selfTest = false;
+    int      reps = CFG::benchReps;
+    const char* baseline = nullptr;              // --bench: compare against this file
+    const char* saveBaseline = nullptr;          // --bench: write this run as one
+    int      coordinator = 0;                    // --coordinator port
+    const char* bind = CFG::coordinatorBind;     // --bind addr
+    const char* workerHost = nullptr;            // --worker host port
+    int      workerPort = 0;
+    int      minRes = CFG::evalMinRes, maxRes = CFG::evalMaxRes, maxSS = CFG::maxSupersample;
+    bool     surrogate = false;
+    float    explore = CFG::surrogateExplore;
+    bool     fidelity = false;
+    float    keep = CFG::fidelityKeep;
+    DeepView view;
+    const char* log = CFG::logFile;
+    const char* csv = nullptr;                   // CSV copy of the log, after the run
+    const char* convert = nullptr;               // --log-to-csv: just convert this log
+    const char* snapshot = nullptr;              // --checkpoint file
+    int      snapshotEvery = 0;                  // 0: the resumed run's, else CFG::snapshotEvery
+    const char* resume = nullptr;
+    int      startGen = 0;                       // from the snapshot
+};
+
+static bool parseArgs(int argc, char** argv, Options& o)
+{
+    for (int a = 1; a < argc; ++a) {
+        const char* k = argv[a];
+        auto has = [&](int n) { return a + n < argc; };
+        if (!std::strcmp(k, "--headless")) o.headless = o.useCpu = true;
+        else if (!std::strcmp(k, "--cpu")) {
+            o.useCpu = true;
+            if (has(1) && argv[a + 1][0] != '-') o.cpuThreads = std::atoi(argv[++a]);
+        }
+        else if (!std::strcmp(k, "--serial")) o.serial = true;
+        else if (!std::strcmp(k, "--gpu")) {
+            o.gpu = true;
+            if (has(1) && argv[a + 1][0] != '-') o.pipeline = std::atoi(argv[++a]);
+        }
+        else if (!std::strcmp(k, "--no-cache")) o.cache = false;
+        else if (!std::strcmp(k, "--threads") && has(1)) o.cpuThreads = std::atoi(argv[++a]);
+        else if (!std::strcmp(k, "--gens") && has(1)) o.gens = std::atoi(argv[++a]);
+        else if (!std::strcmp(k, "--pop") && has(1)) o.popSize = std::atoi(argv[++a]);
+        else if (!std::strcmp(k, "--seed") && has(1)) o.seed = (unsigned)std::strtoul(argv[++a], nullptr, 10);
+        else if (!std::strcmp(k, "--log") && has(1)) o.log = argv[++a];
+        else if (!std::strcmp(k, "--csv") && has(1)) o.csv = argv[++a];
+        else if (!std::strcmp(k, "--checkpoint") && has(1)) {
+            o.snapshot = argv[++a];
+            if (has(1) && argv[a + 1][0] != '-') {
+                o.snapshotEvery = std::atoi(argv[++a]);
+                if (o.snapshotEvery < 1) o.snapshotEvery = -1;   // rejected below
+            }
+        }
+        else if (!std::strcmp(k, "--resume") && has(1)) o.resume = argv[++a];
+        else if (!std::strcmp(k, "--log-to-csv") && has(2)) { o.convert = argv[++a]; o.csv = argv[++a]; }
+        else if (!std::strcmp(k, "--view") && has(3)) {
+            o.view.cx = ddFromString(argv[++a]);
+            o.view.cy = ddFromString(argv[++a]);
+            o.view.zoom = std::strtod(argv[++a], nullptr);
+        }
+        else if (!std::strcmp(k, "--deep")) o.deep = true;
+        else if (!std::strcmp(k, "--no-interior")) o.interior = false;
+        else if (!std::strcmp(k, "--subdivide")) o.subdivide = true;
+        else if (!std::strcmp(k, "--progressive")) o.progressive = true;
+        else if (!std::strcmp(k, "--tiles")) o.tiles = true;
+        else if (!std::strcmp(k, "--banded")) o.smooth = false;
+        else if (!std::strcmp(k, "--archive")) o.archive = true;
+        else if (!std::strcmp(k, "--res") && has(1)) o.minRes = o.maxRes = std::atoi(argv[++a]);
+        else if (!std::strcmp(k, "--ss") && has(1)) o.maxSS = std::atoi(argv[++a]);
+        else if (!std::strcmp(k, "--surrogate")) {
+            o.surrogate = true;
+            if (has(1) && argv[a + 1][0] != '-') o.explore = (float)std::atof(argv[++a]);
+        }
+        else if (!std::strcmp(k, "--fidelity")) {
+            o.fidelity = true;
+            if (has(1) && argv[a + 1][0] != '-') o.keep = (float)std::atof(argv[++a]);
+        }
+        else if (!std::strcmp(k, "--bench-sort")) o.benchSort = true;
+        else if (!std::strcmp(k, "--bench")) o.bench = true;
+        else if (!std::strcmp(k, "--self-test")) o.selfTest = true;
+        else if (!std::strcmp(k, "--reps") && has(1)) o.reps = std::atoi(argv[++a]);
+        else if (!std::strcmp(k, "--baseline") && has(1)) o.baseline = argv[++a];
+        else if (!std::strcmp(k, "--save-baseline") && has(1)) o.saveBaseline = argv[++a];
+        else if (!std::strcmp(k, "--coordinator") && has(1)) {
+            o.headless = o.useCpu = true;
+            o.coordinator = std::atoi(argv[++a]);
+            if (!o.coordinator) o.coordinator = -1;   // rejected below
+        }
+        else if (!std::strcmp(k, "--bind") && has(1)) o.bind = argv[++a];
+        else if (!std::strcmp(k, "--worker") && has(2)) {
+            o.workerHost = argv[++a];
+            o.workerPort = std::atoi(argv[++a]);
+        }
+        else { std::cerr << "Unknown or incomplete option: " << k << "\n"; return false; }
+    }
+    if (o.popSize < 2 || o.gens < 0) { std::cerr << "Bad --pop/--gens\n"; return false; }
+    if (!(o.view.zoom > 0.0)) { std::cerr << "Bad --view zoom\n"; return false; }
+    if (o.minRes < CFG::minResLimit || o.minRes > CFG::maxResLimit
+        || (o.minRes & (o.minRes - 1)) || o.maxSS < 1) {
+        std::cerr << "Bad --res (power of two, 8..4096) or --ss\n"; return false;
+    }
+    if (o.explore < 0.0f || o.explore > 1.0f) { std::cerr << "Bad --surrogate fraction\n"; return false; }
+    if (!(o.keep > 0.0f && o.keep <= 1.0f)) { std::cerr << "Bad --fidelity fraction\n"; return false; }
+    if (o.reps < 2) { std::cerr << "Bad --reps (at least 2)\n"; return false; }
+    if (o.snapshotEvery < 0) { std::cerr << "Bad --checkpoint interval\n"; return false; }
+    if (o.coordinator < 0 || o.coordinator > 65535 || (o.workerHost && (o.workerPort < 1 || o.workerPort > 65535))) {
+        std::cerr << "Bad --coordinator/--worker port\n"; return false;
+    }
+    if (o.resume && !o.snapshot) o.snapshot = o.resume;   // keep the same file going
+    return true;
+}
+
+static GenomeBounds genomeBounds(const Options& o)
+{
+    GenomeBounds b;
+    b.minIter = CFG::minIterLOD; b.maxIter = CFG::maxIterLOD;
+    b.minRes = o.minRes; b.maxRes = o.maxRes;
+    b.maxSupersample = o.maxSS;
+    b.maxSide = std::max(CFG::evalMaxSide, o.maxRes);
+    b.interior = o.interior;
+    return b;
+}
+
+// the widest box genomeBounds() gives for any options a coordinator accepts:
+// what a worker renders, without having to be started with the same ones
+static GenomeBounds workerBounds()
+{
+    GenomeBounds b;
+    b.minIter = CFG::minIterLOD; b.maxIter = CFG::maxIterLOD;
+    b.minRes = CFG::minResLimit; b.maxRes = CFG::maxResLimit;
+    b.maxSide = std::max(CFG::evalMaxSide, CFG::maxResLimit);
+    b.maxSupersample = b.maxSide;                // --ss is open-ended, side is not
+    return b;
+}
+
+static NSGAII makeEvolution(const Options& o)
+{
+    NSGAII evo(o.popSize, genomeBounds(o), o.seed);
+    Variation v;
+    v.crossProb = CFG::crossoverProb; v.etaC = CFG::crossoverEta;
+    v.mutProb = CFG::mutateProb; v.etaM = CFG::mutateEta;
+    evo.setVariation(v);
+    Screening s;
+    s.on = o.surrogate; s.explore = o.explore; s.kappa = CFG::surrogateKappa;
+    s.minTrain = CFG::surrogateMinTrain; s.capacity = CFG::surrogateCapacity;
+    evo.setScreening(s);
+    evo.enableArchive(o.archive);
+    return evo;
+}
+
+// ─── shared evaluation / logging ─────────────────────────────────────────────
+// render evo.current() with r (view already set) and store + log its fitness;
+// genomes already in the cache are not rendered again
+static void evaluateCurrent(RenderBackend& r, ThreadPool* pool, FitnessCache* cache,
+    NSGAII& evo, BinaryLogger& log, int gen, int idx)
+{
+    Fitness f;
+    const Genome g = evo.current().g;
+    if (!cache || !cache->lookup(g, f)) {
+        r.setGenome(g);
+        r.renderOffscreen();
+        f = measureFitness(r, g, CFG::targetFPS, pool);
+        if (cache) cache->store(g, f);
+    }
+    evo.setFitness(f.fpsErr, f.gpuMs, f.boundary, f.density);
+    log.row("EVAL", gen, idx, g.maxIter,
+        f.fpsErr, f.gpuMs, int(f.boundary), f.density, -1,
+        g.res, g.supersample, int(g.interior));
+}
+
+// an evaluated individual as a CSV row (objectives back to their signs)
+static void logIndividual(BinaryLogger& log, const char* tag, int gen, int idx, const Individual& ind)
+{
+    log.row(tag, gen, idx, ind.g.maxIter, ind.obj[0], ind.obj[1],
+        -ind.obj[2], -ind.obj[3], ind.rank,
+        ind.g.res, ind.g.supersample, int(ind.g.interior));
+}
+
+// surrogate predictions vs. what this generation's renders measured
+static void logScreening(const NSGAII& evo, BinaryLogger& log, int gen)
+{
+    const auto& pop = evo.population();
+    for (size_t i = 0; i < pop.size(); ++i) {
+        float p[4];
+        if (!evo.prediction(static_cast<int>(i), p)) continue;
+        log.row("PRED", gen, static_cast<int>(i), pop[i].g.maxIter, p[0], p[1], p[2], p[3], -1,
+            pop[i].g.res, pop[i].g.supersample, int(pop[i].g.interior));
+    }
+    for (size_t i = 0; i < evo.skipped().size(); ++i) {
+        Individual ind = evo.skipped()[i];
+        ind.rank = -1;
+        logIndividual(log, "SKIP", gen, static_cast<int>(i), ind);
+    }
+    const ScreenStats& s = evo.screenStats();
+    log.row("SURR", gen, s.rendered, s.skipped,
+        s.relErr[0], s.relErr[1], s.relErr[2], s.relErr[3], s.trained);
+}
+
+// keep the best of survivors + this generation, log their front and breed
+// the next one
+static void finishGeneration(NSGAII& evo, BinaryLogger& log, int gen, StageTimes* stages)
+{
+    {
+        ScopedStage st(stages, Stage::Evolve);
+        evo.select();
+    }
+    for (size_t i = 0; i < evo.elite().size(); ++i)
+        if (evo.elite()[i].rank == 0)
+            logIndividual(log, "FRONT", gen, static_cast<int>(i), evo.elite()[i]);
+    if (evo.screening()) logScreening(evo, log, gen);
+    ScopedStage st(stages, Stage::Evolve);
+    evo.breed();
+}
+
+// all-time non-dominated set (--archive), after the last generation
+static void logArchive(const NSGAII& evo, BinaryLogger& log, int gen)
+{
+    const auto& a = evo.archive().members();
+    for (size_t i = 0; i < a.size(); ++i) {
+        Individual ind = a[i];
+        ind.rank = 0;
+        logIndividual(log, "ARCH", gen, static_cast<int>(i), ind);
+    }
+}
+
+// store + log one generation of batch results (in job order)
+static void recordBatch(NSGAII& evo, BinaryLogger& log, int gen,
+    const std::vector<EvalJob>& jobs, const std::vector<Fitness>& results)
+{
+    for (size_t k = 0; k < jobs.size(); ++k) {
+        const Fitness& f = results[k];
+        const Genome& g = jobs[k].g;
+        evo.setFitness(jobs[k].idx, f.fpsErr, f.gpuMs, f.boundary, f.density);
+        log.row("EVAL", gen, jobs[k].idx, g.maxIter,
+            f.fpsErr, f.gpuMs, int(f.boundary), f.density, -1,
+            g.res, g.supersample, int(g.interior));
+    }
+}
+
+// one job at a time on the tile-parallel CPU renderer (--serial)
+static void evaluateSerial(CpuMandelbrotRenderer& r, FitnessCache* cache,
+    const std::vector<EvalJob>& jobs, std::vector<Fitness>& out)
+{
+    out.resize(jobs.size());
+    for (size_t k = 0; k < jobs.size(); ++k) {
+        if (cache && cache->lookup(jobs[k].g, out[k])) continue;
+        r.setGenome(jobs[k].g);
+        r.renderOffscreen();
+        out[k] = measureFitness(r, jobs[k].g, CFG::targetFPS, &r.threadPool());
+        if (cache) cache->store(jobs[k].g, out[k]);
+    }
+}
+
+// GPU pipeline: metrics of job k are computed while job k+depth-1 is drawn.
+// As in BatchEvaluator, only the first job of each uncached genome is
+// submitted; its duplicates read the cache once the pipeline is drained.
+static void evaluatePipelined(MandelbrotRenderer& r, ThreadPool* pool, FitnessCache* cache,
+    const std::vector<EvalJob>& jobs, std::vector<Fitness>& out)
+{
+    out.resize(jobs.size());
+    auto finish = [&](int k) {                   // counts are job k's, at its side²
+        out[k] = measureFitness(r, jobs[k].g, CFG::targetFPS, pool);
+        if (cache) cache->store(jobs[k].g, out[k]);
+    };
+    std::vector<int> dupes;
+    std::unordered_map<std::uint64_t, int> pending;   // genome key → submitted job
+    int done;
+    for (int k = 0; k < (int)jobs.size(); ++k) {
+        if (cache) {
+            if (pending.count(jobs[k].g.key())) { dupes.push_back(k); continue; }
+            if (cache->lookup(jobs[k].g, out[k])) continue;
+            pending.emplace(jobs[k].g.key(), k);
+        }
+        r.setGenome(jobs[k].g);
+        if (r.submitOffscreen(k, done)) finish(done);
+    }
+    while (r.drainOffscreen(done)) finish(done);
+    for (int k : dupes) cache->lookup(jobs[k].g, out[k]);
+}
+
+static void printCacheStats(const FitnessCache& c)
+{
+    auto total = c.hits() + c.misses();
+    std::cout << "Fitness cache: " << c.hits() << " hits / " << c.misses() << " misses ("
+        << (total ? 100.0 * c.hits() / total : 0.0) << "% renders skipped)\n";
+}
+
+static void printScreenStats(const ScreenStats& s)
+{
+    auto total = s.renderedTotal + s.skippedTotal;
+    std::cout << "Surrogate: " << s.renderedTotal << " children rendered / " << s.skippedTotal
+        << " skipped (" << (total ? 100.0 * s.skippedTotal / total : 0.0) << "% renders avoided)\n";
+}
+
+// renders per fidelity level over the run; summed rank correlations
+struct FidelityTotals {
+    std::vector<int> side;                       // 0: the genome's own buffer
+    std::vector<long long> rendered;
+    std::vector<double> rho[4];
+    std::vector<int> gens;                       // generations with a correlation
+};
+
+// FIDL,gen,level,rendered,4× Spearman ρ vs. the next level,promoted,side
+static void logFidelity(const MultiFidelity& mf, FidelityTotals& t, BinaryLogger& log, int gen)
+{
+    const auto& st = mf.stats();
+    const size_t n = st.size();
+    t.side.resize(n); t.rendered.resize(n); t.gens.resize(n);
+    for (auto& r : t.rho) r.resize(n);
+    for (size_t l = 0; l < n; ++l) {
+        const FidelityStats& s = st[l];
+        log.row("FIDL", gen, static_cast<int>(l), s.evaluated,
+            s.spearman[0], s.spearman[1], s.spearman[2], s.spearman[3], s.promoted, s.res);
+        t.side[l] = s.res;
+        t.rendered[l] += s.evaluated;
+        if (std::isnan(s.spearman[1])) continue;
+        for (int m = 0; m < 4; ++m) t.rho[m][l] += std::isnan(s.spearman[m]) ? 0.0 : s.spearman[m];
+        ++t.gens[l];
+    }
+}
+
+static void printFidelityStats(const FidelityTotals& t)
+{
+    std::cout << "Multi-fidelity:";
+    for (size_t l = 0; l < t.rendered.size(); ++l) {
+        std::cout << (l ? " ->" : "") << " " << t.rendered[l] << " at ";
+        if (t.side[l]) std::cout << t.side[l] << "x" << t.side[l];
+        else std::cout << "full res";
+        if (!t.gens[l]) continue;
+        std::cout << " (mean rho vs. next " << std::setprecision(2);
+        for (int m = 0; m < 4; ++m) std::cout << (m ? "/" : "") << t.rho[m][l] / t.gens[l];
+        std::cout << std::setprecision(6) << ")";
+    }
+    std::cout << "\n";
+}
+
+// batch workers overlap, so their wall time is worker-ms
+static void printStageTimes(const StageTimes& t)
+{
+    std::cout << "Stages (wall / CPU ms):" << std::fixed << std::setprecision(1);
+    for (int k = 0; k < NSTAGE; ++k)
+        if (t.calls[k]) std::cout << "  " << stageName(Stage(k)) << " " << t.wallMs[k] << " / " << t.cpuMs[k];
+    std::cout << std::defaultfloat << std::setprecision(6) << "\n";
+}
+
+static void printRenderStats(const char* what, const RenderStats& s)
+{
+    auto total = s.computed + s.filled;
+    std::cout << what << ": " << s.computed << " pixels computed / " << s.filled << " filled ("
+        << (total ? 100.0 * s.filled / total : 0.0) << "% not iterated)\n";
+}
+
+// per worker of a --coordinator run: jobs/s while rendering, share of the
+// connected time spent rendering
+static void printWorkerStats(const std::vector<WorkerStats>& ws)
+{
+    std::cout << "Workers: " << ws.size() << std::fixed << std::setprecision(1) << "\n";
+    for (const WorkerStats& w : ws)
+        std::cout << "  " << w.name << ": " << w.threads << " threads, " << w.batches << " batches, "
+            << w.jobs << " jobs, " << (w.busyMs > 0 ? 1000.0 * w.jobs / w.busyMs : 0.0) << " jobs/s, "
+            << (w.connectedSec > 0 ? w.busyMs / (10.0 * w.connectedSec) : 0.0) << "% busy, "
+            << w.redispatched << " re-dispatched" << (w.lost ? ", lost" : "") << "\n";
+    std::cout << std::defaultfloat << std::setprecision(6);
+}
+
+static void printTileStats(const TileStats& s)
+{
+    auto total = s.hits + s.misses;
+    const double mb = 1.0 / (1 << 20);
+    std::cout << "Tile cache: " << s.hits << " hits / " << s.misses << " misses ("
+        << (total ? 100.0 * s.hits / total : 0.0) << "% hit rate), " << s.rendered << " rendered ("
+        << s.prefetched << " prefetched), " << s.evicted << " evicted, " << s.tiles << " tiles: "
+        << s.bytesUsed * mb << " MB used / " << s.bytesReserved * mb << " MB allocated / "
+        << s.bytesBudget * mb << " MB budget\n";
+}
+
+// ─── snapshots ───────────────────────────────────────────────────────────────
+// A snapshot taken after generation gen−1 is bred: the options that shape
+// the search (backend, threads, --gens and output files may change on
+// resume), then the evolution state and the fitness cache.
+static void checkpoint(SnapshotWriter& w, const Options& o, int gen, const DeepView& view,
+    const NSGAII& evo, const FitnessCache& cache)
+{
+    ByteWriter out;
+    beginSnapshot(out);
+    out.put(gen); out.put(o.seed); out.put(o.popSize); out.put(o.snapshotEvery);
+    out.put(view); out.put(o.deep); out.put(o.interior); out.put(o.subdivide);
+    out.put(o.minRes); out.put(o.maxRes); out.put(o.maxSS);
+    out.put(o.surrogate); out.put(o.explore);
+    out.put(o.fidelity); out.put(o.keep);
+    out.put(o.archive); out.put(o.cache);
+    evo.save(out);
+    cache.save(out);
+    w.submit(o.snapshot, std::move(out.bytes));
+}
+
+static bool resumeOptions(ByteReader& in, Options& o)
+{
+    if (!checkSnapshot(in, o.resume)) return false;
+    int every = 0;                               // a --checkpoint interval given now wins
+    in.get(o.startGen); in.get(o.seed); in.get(o.popSize); in.get(every);
+    if (!o.snapshotEvery) o.snapshotEvery = every;
+    in.get(o.view); in.get(o.deep); in.get(o.interior); in.get(o.subdivide);
+    in.get(o.minRes); in.get(o.maxRes); in.get(o.maxSS);
+    in.get(o.surrogate); in.get(o.explore);
+    in.get(o.fidelity); in.get(o.keep);
+    in.get(o.archive); in.get(o.cache);
+    if (!in.ok() || o.startGen < 0 || o.popSize < 2 || o.snapshotEvery < 1) { std::cerr << o.resume << ": bad snapshot\n"; return false; }
+    return true;
+}
+
+// the rest of the snapshot, into objects built from the resumed options
+static bool resumeState(ByteReader* in, const Options& o, NSGAII& evo, FitnessCache& cache)
+{
+    if (!in) return true;
+    const bool ok = evo.load(*in);
+    if (ok) cache.load(*in);
+    if (!ok || !in->ok()) { std::cerr << o.resume << ": snapshot does not match this build\n"; return false; }
+    std::cout << "Resumed " << o.resume << " at gen " << o.startGen << "\n";
+    return true;
+}
+
+static bool snapshotDue(const Options& o, int gen, int lastGen)
+{
+    return o.snapshot && (gen % o.snapshotEvery == 0 || gen == lastGen);
+}
+
+// ─── headless batch mode ─────────────────────────────────────────────────────
+static int runHeadless(const Options& o, ByteReader* resume)
+{
+    NSGAII       evo = makeEvolution(o);
+    BinaryLogger log(o.log, CFG::logRing);
+    if (!log.ok()) return -1;
+    FitnessCache cache(CFG::cacheQuantum, genomeBounds(o).maxSide);
+    FitnessCache* fc = o.cache ? &cache : nullptr;
+    if (!resumeState(resume, o, evo, cache)) return -1;
+    SnapshotWriter snapshots;
+
+    std::unique_ptr<HeadlessGL>            gl;
+    std::unique_ptr<MandelbrotRenderer>    gpu;
+    std::unique_ptr<ThreadPool>            metricsPool;
+    std::unique_ptr<CpuMandelbrotRenderer> cpu;
+    std::unique_ptr<BatchEvaluator>        batch;
+    std::unique_ptr<RemoteEvaluator>       remote;
+    if (o.coordinator) {
+        remote = std::make_unique<RemoteEvaluator>(o.bind, o.coordinator,
+            CFG::remoteBatchPerThread, CFG::workerSilentMs, CFG::batchLateMs);
+        if (!remote->ok()) return -1;
+    }
+    else if (o.gpu) {
+        gl = std::make_unique<HeadlessGL>();
+        if (!gl->ok()) return -1;
+        gpu = std::make_unique<MandelbrotRenderer>(CFG::winW, CFG::winH);
+        gpu->setPipelineDepth(o.pipeline);
+        metricsPool = std::make_unique<ThreadPool>(o.cpuThreads);
+    }
+    else if (o.serial) cpu = std::make_unique<CpuMandelbrotRenderer>(CFG::winW, CFG::winH, o.cpuThreads);
+    else batch = std::make_unique<BatchEvaluator>(CFG::winW, CFG::winH, CFG::targetFPS, o.cpuThreads);
+
+    std::cout << "Headless: " << o.gens << " gens x " << o.popSize
+        << " individuals, seed " << o.seed << ", ";
+    if (remote) std::cout << "workers via " << o.bind << ":" << o.coordinator << "\n";
+    else if (gpu) std::cout << gl->rendererName() << ", " << gpu->pipelineDepth() << " frames in flight\n";
+    else if (cpu) std::cout << cpu->threads() << " tile threads\n";
+    else std::cout << batch->workers() << " workers\n";
+
+    const bool deep = o.deep || o.view.zoom < CFG::deepZoomBelow;
+    if (gpu) gpu->setDeepZoom(deep);
+    if (cpu) cpu->setDeepZoom(deep);
+    if (batch) batch->setDeepZoom(deep);
+    if (remote) remote->setDeepZoom(deep);
+    if (cpu) cpu->setSubdivision(o.subdivide);
+    if (batch) batch->setSubdivision(o.subdivide);
+    if (remote) remote->setSubdivision(o.subdivide);
+    if (gpu && o.subdivide) std::cerr << "--subdivide only applies to CPU renders\n";
+    StageTimes stages;                           // batch workers keep their own
+    if (gpu) gpu->setStageTimes(&stages);
+    if (cpu) cpu->setStageTimes(&stages);
+
+    auto render = [&](const std::vector<EvalJob>& jobs, std::vector<Fitness>& out) {
+        if (remote) remote->evaluate(jobs, o.view, out, fc);
+        else if (gpu) evaluatePipelined(*gpu, metricsPool.get(), fc, jobs, out);
+        else if (cpu) evaluateSerial(*cpu, fc, jobs, out);
+        else batch->evaluate(jobs, o.view, out, fc);
+    };
+    MultiFidelity mf(std::vector<int>(std::begin(CFG::fidelityLevels), std::end(CFG::fidelityLevels)),
+        o.keep, CFG::targetFPS);
+    FidelityTotals fidelity;
+
+    std::vector<Fitness> results, full;
+    std::vector<char> kept;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int gen = o.startGen; gen < o.gens; ++gen) {
+        if (gpu) gpu->setView(o.view);
+        if (cpu) cpu->setView(o.view);
+        cache.setView(o.view);
+        std::vector<EvalJob> jobs = evo.jobs();
+        if (o.fidelity) {                        // children not promoted are dropped
+            mf.run(jobs, render, kept, full);
+            evo.retain(kept);
+            results.clear();
+            for (size_t k = 0; k < kept.size(); ++k) if (kept[k]) results.push_back(full[k]);
+            jobs = evo.jobs();
+            logFidelity(mf, fidelity, log, gen);
+        }
+        else render(jobs, results);
+        recordBatch(evo, log, gen, jobs, results);
+        finishGeneration(evo, log, gen, &stages);
+        if (snapshotDue(o, gen + 1, o.gens)) checkpoint(snapshots, o, gen + 1, o.view, evo, cache);
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    const int ran = std::max(0, o.gens - o.startGen);
+    std::cout << "Run complete: " << sec << " s ("
+        << (ran ? sec * 1000.0 / ran : 0.0) << " ms/gen). Log written to " << o.log << "\n";
+    if (fc) printCacheStats(cache);
+    if (cpu) printRenderStats("Fitness renders", cpu->stats());
+    if (batch) printRenderStats("Fitness renders", batch->stats());
+    if (batch) stages.add(batch->stageTimes());
+    printStageTimes(stages);
+    if (remote) printWorkerStats(remote->stats());
+    if (o.surrogate) printScreenStats(evo.screenStats());
+    if (o.fidelity) printFidelityStats(fidelity);
+    if (o.archive) {
+        logArchive(evo, log, o.gens);
+        std::cout << "Pareto archive: " << evo.archive().size() << " individuals\n";
+    }
+    if (o.snapshot) std::cout << "Snapshot: " << o.snapshot << " (every " << o.snapshotEvery << " gens)\n";
+    return 0;
+}
+
+// ─── interactive mode ────────────────────────────────────────────────────────
+static int runInteractive(const Options& o, ByteReader* resume)
+{
     // ─── GLFW / GLAD init ───────────────────────────────────────────────────
     if (!glfwInit()) { std::cerr << "GLFW failed\n"; return -1; }
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
@@ -60,82 +758,468 @@ int main() {
 
     // ─── components ─────────────────────────────────────────────────────────
     MandelbrotRenderer renderer(CFG::winW, CFG::winH);          // off‑screen size set inside
-    NSGAII             evo(CFG::popSize, CFG::minIterLOD, CFG::maxIterLOD);
-    CSVLogger          log(CFG::csvFile);
+    renderer.setSmooth(o.smooth);
+    std::unique_ptr<CpuMandelbrotRenderer> cpu;
+    if (o.useCpu) cpu = std::make_unique<CpuMandelbrotRenderer>(CFG::winW, CFG::winH, o.cpuThreads);
+    RenderBackend&     evalR = cpu ? static_cast<RenderBackend&>(*cpu) : renderer;
+    NSGAII             evo = makeEvolution(o);
+    BinaryLogger       log(o.log, CFG::logRing);
+    if (!log.ok()) return -1;
+    FitnessCache       cache(CFG::cacheQuantum, genomeBounds(o).maxSide);
+    FitnessCache*      fc = o.cache ? &cache : nullptr;
+    if (!resumeState(resume, o, evo, cache)) return -1;
+    SnapshotWriter     snapshots;
+    StageTimes         stages;                   // of the fitness evaluations
+    evalR.setStageTimes(&stages);
+    ThreadPool         metricsPool(cpu ? 1 : o.cpuThreads);   // row bands of the GPU readback
+    if (cpu) cpu->setSubdivision(o.subdivide);
+
+    // --progressive: the onscreen view comes from a window-sized CPU render
+    // that is refined a little every frame instead of redrawn on the GPU
+    std::unique_ptr<CpuMandelbrotRenderer> preview;
+    if (o.progressive) {
+        preview = std::make_unique<CpuMandelbrotRenderer>(CFG::winW, CFG::winH, o.cpuThreads);
+        preview->setInteriorCheck(o.interior);
+        preview->setSubdivision(o.subdivide);
+    }
+    // --tiles: the onscreen view from the tile cache, outside deep zoom
+    // (there --progressive or the GPU take over)
+    std::unique_ptr<TileCache> tiles;
+    std::vector<std::uint16_t> tileView;
+    if (o.tiles) tiles = std::make_unique<TileCache>(std::size_t(CFG::tileCacheMB) << 20,
+        CFG::tileThreads, o.interior, o.subdivide);
 
     // Camera state
-    float cx = -0.5f, cy = 0.0f, zoom = 1.0f;
-    float view[3] = { cx, cy, zoom };
-    glfwSetWindowUserPointer(win, view);
+    DeepView view = o.view;                      // double-double centre
+    glfwSetWindowUserPointer(win, &view);
     glfwSetKeyCallback(win, [](GLFWwindow* w, int key, int, int act, int) {
         if (act != GLFW_PRESS && act != GLFW_REPEAT) return;
-        auto* v = static_cast<float*>(glfwGetWindowUserPointer(w));
-        float& cx = v[0], & cy = v[1], & z = v[2];
-        float pan = CFG::panSpeed * z;
+        auto* v = static_cast<DeepView*>(glfwGetWindowUserPointer(w));
+        // snapped to whole framebuffer pixels, so a CPU-rendered view scrolls
+        int fw, fh; glfwGetFramebufferSize(w, &fw, &fh);
+        if (fw <= 0 || fh <= 0) return;
+        double px = std::max(1.0, std::round(double(CFG::panSpeed) * fh));
+        dd panX(px * v->zoom * CFG::winW / CFG::winH / fw), panY(px * v->zoom / fh);
         switch (key) {
-        case GLFW_KEY_UP: cy += pan; break;
-        case GLFW_KEY_DOWN: cy -= pan; break;
-        case GLFW_KEY_LEFT: cx -= pan; break;
-        case GLFW_KEY_RIGHT: cx += pan; break;
-        case GLFW_KEY_Z: z /= CFG::zoomFactor; break;
-        case GLFW_KEY_X: z *= CFG::zoomFactor; break;
+        case GLFW_KEY_UP: v->cy = v->cy + panY; break;
+        case GLFW_KEY_DOWN: v->cy = v->cy - panY; break;
+        case GLFW_KEY_LEFT: v->cx = v->cx - panX; break;
+        case GLFW_KEY_RIGHT: v->cx = v->cx + panX; break;
+        case GLFW_KEY_Z: v->zoom /= CFG::zoomFactor; break;
+        case GLFW_KEY_X: v->zoom *= CFG::zoomFactor; break;
         }
         });
 
     // ─── evolutionary loop ─────────────────────────────────────────────────
-    int gen = 0, idx = 0;
+    int gen = o.startGen, idx = 0;
+    std::uint64_t modelView = cache.view();      // view the surrogate and archive hold
     while (!glfwWindowShouldClose(win)) {
-        // fetch updated view
-        cx = view[0]; cy = view[1]; zoom = view[2];
-
-        // set genome + view
-        renderer.setView(cx, cy, zoom);
-        renderer.setMaxIter(evo.current().maxIter);
-        renderer.renderOffscreen();
-
-        // ----- fitness metrics -----
-        float fpsErr = std::abs(renderer.fps() - CFG::targetFPS);
-        float gpuMs = renderer.lastGpuTimeMs();
-
-        const unsigned char* px = renderer.pixelPtr();
-        int edges = 0; double sum = 0, sum2 = 0;
-        for (int y = 1; y < MandelbrotRenderer::OFF_H; ++y)
-            for (int x = 1; x < MandelbrotRenderer::OFF_W; ++x) {
-                int i = y * MandelbrotRenderer::OFF_W + x;
-                if (px[i] != px[i - 1] || px[i] != px[i - MandelbrotRenderer::OFF_W]) ++edges;
-            }
-        for (int i = 0; i < MandelbrotRenderer::OFF_W * MandelbrotRenderer::OFF_H; ++i) {
-            float v = px[i] / 255.f; sum += v; sum2 += v * v;
-        }
-        int N = MandelbrotRenderer::OFF_W * MandelbrotRenderer::OFF_H;
-        float var = (sum2 / N) - float(sum / N) * float(sum / N);
+        // updated view; deep zoom takes over where floats run out
+        bool deep = o.deep || view.zoom < CFG::deepZoomBelow;
+        renderer.setDeepZoom(deep);
+        evalR.setDeepZoom(deep);
 
-        evo.setFitness(fpsErr, gpuMs, float(edges), var);
-        log.row("EVAL", gen, idx, evo.current().maxIter,
-            fpsErr, gpuMs, edges, var, -1);
+        // set genome + view, render and score
+        renderer.setView(view);
+        evalR.setView(view);
+        cache.setView(view);                        // camera moved → entries dropped
+        if (cache.view() != modelView) {            // generation restarts, survivors included
+            evo.resetObjectives();
+            modelView = cache.view();
+            idx = 0;
+        }
+        evaluateCurrent(evalR, cpu ? &cpu->threadPool() : &metricsPool, fc, evo, log, gen, idx);
 
         // draw best individual onscreen
-        renderer.setMaxIter(evo.best().maxIter);
-        renderer.renderOnscreen();
+        if (tiles && !deep) {
+            int fw, fh; glfwGetFramebufferSize(win, &fw, &fh);
+            if (fw > 0 && fh > 0) {                      // not minimised
+                const int it = TileCache::keyIter(evo.best().g.maxIter);   // shared by nearby genes
+                tiles->compose(view, float(CFG::winW) / CFG::winH, it, fw, fh, tileView);
+                renderer.renderOnscreen(tileView.data(), fw, fh, it);
+            }
+        }
+        else if (preview) {
+            int fw, fh; glfwGetFramebufferSize(win, &fw, &fh);
+            if (fw != preview->width() || fh != preview->height()) preview->setResolution(fw, fh);
+            preview->setDeepZoom(deep);
+            preview->setView(view);
+            preview->setMaxIter(evo.best().g.maxIter);     // unchanged → keeps refining
+            preview->refine(CFG::frameBudgetMs);
+            renderer.renderOnscreen(preview->iterationPtr(), fw, fh, evo.best().g.maxIter);
+        }
+        else {
+            renderer.setMaxIter(evo.best().g.maxIter);
+            renderer.setInteriorCheck(evo.best().g.interior);
+            renderer.renderOnscreen();
+        }
 
         glfwSwapBuffers(win);
         glfwPollEvents();
 
         // move to next individual / generation
         if (evo.nextIndividual()) {
-            evo.recalcRanks();
-            for (size_t i = 0; i < evo.population().size(); ++i)
-                if (evo.population()[i].rank == 0)
-                    log.row("FRONT", gen, static_cast<int>(i), evo.population()[i].maxIter,
-                        evo.population()[i].obj[0], evo.population()[i].obj[1],
-                        -evo.population()[i].obj[2], -evo.population()[i].obj[3],
-                        evo.population()[i].rank);
-            evo.evolve();
+            finishGeneration(evo, log, gen, &stages);
             ++gen; idx = 0;
+            if (snapshotDue(o, gen, -1)) checkpoint(snapshots, o, gen, view, evo, cache);
         }
         else ++idx;
     }
     glfwTerminate();
-    std::cout << "Run complete. CSV written to " << CFG::csvFile << "\n";
+    std::cout << "Run complete. Log written to " << o.log << "\n";
+    if (fc) printCacheStats(cache);
+    if (cpu) printRenderStats("Fitness renders", cpu->stats());
+    if (preview) printRenderStats("Onscreen view", preview->stats());
+    if (tiles) printTileStats(tiles->stats());
+    printStageTimes(stages);
+    if (o.surrogate) printScreenStats(evo.screenStats());
+    if (o.archive) logArchive(evo, log, gen);
+    return 0;
+}
+
+// ─── --worker ────────────────────────────────────────────────────────────────
+// renders what a --coordinator run sends, on its own BatchEvaluator
+static int runWorker(const Options& o)
+{
+    BatchEvaluator eval(CFG::winW, CFG::winH, CFG::targetFPS, o.cpuThreads);
+    std::cout << "Worker: " << eval.workers() << " threads, coordinator "
+        << o.workerHost << ":" << o.workerPort << "\n";
+    return RemoteWorker(eval, workerBounds(), CFG::heartbeatMs, CFG::workerRetrySec)
+        .run(o.workerHost, o.workerPort);
+}
+
+// ─── --bench-sort ────────────────────────────────────────────────────────────
+// Random 4-objective populations: "cube" (uniform, many small fronts) and
+// "tradeoff" (near the plane Σ=1, few large fronts, like converged runs).
+static int runSortBenchmark(const Options& o)
+{
+    std::mt19937 rng(o.seed);
+    std::uniform_real_distribution<float> u(0.0f, 1.0f);
+    NonDominatedSort fast;
+
+    auto timeMs = [](auto&& fn) {               // best of repeats within ~0.2 s
+        double best = 1e300, total = 0;
+        do {
+            auto t0 = std::chrono::steady_clock::now();
+            fn();
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            best = std::min(best, ms); total += ms;
+        } while (total < 200.0);
+        return best;
+    };
+
+    std::cout << std::fixed << std::setprecision(2)
+        << "layout        N    fronts  reference ms   fast ms  speedup  ranks\n";
+    for (int layout = 0; layout < 2; ++layout)
+        for (int n = 48; n <= 65536; n *= 4) {
+            std::vector<float> keys(n * NOBJ);
+            for (int i = 0; i < n; ++i) {
+                float* k = &keys[i * NOBJ], sum = 0.0f;
+                for (int m = 0; m < NOBJ; ++m) sum += (k[m] = u(rng));
+                if (layout == 1)
+                    for (int m = 0; m < NOBJ; ++m) k[m] = k[m] / sum + 0.02f * u(rng);
+            }
+            std::vector<int> rFast(n), rRef(n);
+            int fronts = 0;
+            double fastMs = timeMs([&] { fronts = fast.sort(keys.data(), n, rFast.data()); });
+
+            std::cout << (layout ? "tradeoff " : "cube     ") << std::setw(6) << n
+                << std::setw(10) << fronts;
+            if (n <= CFG::benchSortRefMax) {
+                double refMs = timeMs([&] { referenceSort(keys.data(), n, rRef.data()); });
+                std::cout << std::setw(14) << refMs << std::setw(10) << fastMs
+                    << std::setw(9) << refMs / fastMs << "x  "
+                    << (rFast == rRef ? "same" : "DIFFER") << "\n";
+            }
+            else std::cout << std::setw(14) << "-" << std::setw(10) << fastMs << "\n";
+        }
     return 0;
 }
+
+// ─── --bench ─────────────────────────────────────────────────────────────────
+// Fixed scenes through one CPU renderer (tile threads from --threads, 1 by
+// default so the rates are per core), each case rendered once untimed and
+// then `reps` times. Iterations are the frame's summed counts, i.e. what a
+// plain escape-time loop would run, so the interior check and subdivision
+// show up as higher rates. The baseline file holds the median evaluations/s
+// and its CV per case; a case regresses only if the drop in the median is
+// beyond both the tolerance and twice the combined CV of the two runs.
+struct BenchScene {
+    const char* name;
+    const char* cx, * cy;
+    double zoom;
+    bool interior;                               // interior check on
+};
+static const BenchScene benchScenes[] = {
+    { "full",     "-0.75", "0", 2.5, true },
+    { "seahorse", "-0.743643887037151", "0.131825904205330", 0.002, true },
+    { "minibrot", "-1.9997740486937274", "0", 6e-8, true },     // period 8, deep kernel
+    { "interior", "-0.2", "0", 0.1, false },                   // every pixel to maxIter
+};
+
+static const char* simdNames[] = { "scalar", "SSE2", "AVX2" };
+
+static DeepView sceneView(const BenchScene& sc)
+{
+    DeepView v;
+    v.cx = ddFromString(sc.cx); v.cy = ddFromString(sc.cy); v.zoom = sc.zoom;
+    return v;
+}
+
+struct Samples {
+    std::vector<double> v;
+    double mean() const { double s = 0; for (double x : v) s += x; return s / v.size(); }
+    double median() const {
+        std::vector<double> w = v;
+        std::sort(w.begin(), w.end());
+        const std::size_t n = w.size();
+        return n % 2 ? w[n / 2] : 0.5 * (w[n / 2 - 1] + w[n / 2]);
+    }
+    double cv() const {                          // sample std. deviation / mean, in %
+        double m = mean(), s2 = 0;
+        for (double x : v) s2 += (x - m) * (x - m);
+        return 100.0 * std::sqrt(s2 / (v.size() - 1)) / m;
+    }
+};
+
+struct BenchCase {
+    double rate = 0, cv = 0;                     // median per second, CV in %
+};
+
+// "case rate cv" lines; older files without the CV read as noise-free
+static bool loadBaseline(const char* fname, std::unordered_map<std::string, BenchCase>& out)
+{
+    std::ifstream in(fname);
+    if (!in) { std::cerr << "Cannot open baseline " << fname << "\n"; return false; }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream ls(line);
+        std::string key; BenchCase c;
+        if (ls >> key >> c.rate) { ls >> c.cv; out[key] = c; }
+    }
+    return true;
+}
+
+static int runBenchmark(const Options& o)
+{
+    std::unordered_map<std::string, BenchCase> base, now;
+    if (o.baseline && !loadBaseline(o.baseline, base)) return -1;
+    CpuMandelbrotRenderer r(CFG::winW, CFG::winH, std::max(1, o.cpuThreads));
+    r.setSubdivision(o.subdivide);
+    StageTimes st;
+    r.setStageTimes(&st);
+    int slower = 0;
+
+    // median evaluations/s of one case against the baseline, if it has the
+    // case; a drop within twice the combined CV is noise
+    auto compare = [&](const std::string& key, const Samples& evals) {
+        const BenchCase c{ evals.median(), evals.cv() };
+        now[key] = c;
+        auto it = base.find(key);
+        if (it == base.end()) return;
+        const double ratio = c.rate / it->second.rate;
+        const double noise = 2.0 * std::hypot(c.cv, it->second.cv) / 100.0;
+        std::cout << std::setw(8) << std::showpos << 100.0 * (ratio - 1.0) << std::noshowpos << "%";
+        if (ratio < 1.0 - std::max(double(CFG::benchTolerance), noise)) { std::cout << " SLOWER"; ++slower; }
+    };
+
+    std::cout << "CPU renderer, " << r.threads() << " tile thread(s), " << simdNames[int(r.simd())]
+        << ", " << o.reps << " reps; mean ± CV, baseline on the median\n" << std::fixed << std::setprecision(2)
+        << "scene     maxIter  res   render ms  (cpu)  metrics ms     Mpix/s        Giter/s       evals/s"
+        << (o.baseline ? "   vs. base" : "") << "\n";
+    for (const BenchScene& sc : benchScenes) {
+        const DeepView v = sceneView(sc);
+        r.setDeepZoom(o.deep || v.zoom < CFG::deepZoomBelow);
+        r.setView(v);
+        for (int it : CFG::benchIters)
+            for (int res : CFG::benchRes) {
+                Genome g;
+                g.maxIter = it; g.res = res; g.supersample = 1; g.interior = sc.interior;
+                r.setGenome(g);
+                r.renderOffscreen();             // warm-up: buffers, reference orbit
+                double counts = 0;
+                for (int i = 0, n = res * res; i < n; ++i) counts += r.iterationPtr()[i];
+
+                Samples pix, iter, evals;
+                double renderCpu = 0, metricsMs = 0, renderMs = 0;
+                for (int k = 0; k < o.reps; ++k) {
+                    st.clear();
+                    r.renderOffscreen();
+                    measureFitness(r, g, CFG::targetFPS);
+                    const double ms = st.wallMs[int(Stage::Render)], mm = st.wallMs[int(Stage::Metrics)];
+                    pix.v.push_back(res * res / (ms * 1e3));
+                    iter.v.push_back(counts / (ms * 1e6));
+                    evals.v.push_back(1000.0 / (ms + mm));
+                    renderMs += ms; metricsMs += mm;
+                    renderCpu += st.cpuMs[int(Stage::Render)];
+                }
+                std::cout << std::left << std::setw(9) << sc.name << std::right << std::setw(8) << it
+                    << std::setw(5) << res << std::setw(11) << renderMs / o.reps
+                    << std::setw(8) << renderCpu / o.reps << std::setw(11) << metricsMs / o.reps;
+                for (const Samples* s : { &pix, &iter, &evals })
+                    std::cout << std::setw(9) << s->mean() << " ±" << std::setw(4) << std::setprecision(1)
+                        << s->cv() << std::setprecision(2);
+                compare(std::string(sc.name) + "/" + std::to_string(it) + "/" + std::to_string(res), evals);
+                std::cout << "\n";
+            }
+    }
+
+    // NSGA-II bookkeeping: select + breed on random objectives
+    NSGAII evo(CFG::popSize, genomeBounds(o), o.seed);
+    std::mt19937 rng(o.seed);
+    std::uniform_real_distribution<float> u(0.0f, 1.0f);
+    Samples evolveMs, gens;
+    for (int k = 0; k < o.reps; ++k) {
+        for (int i = 0; i < evo.size(); ++i) evo.setFitness(i, u(rng), u(rng), u(rng), u(rng));
+        st.clear();
+        {
+            ScopedStage t(&st, Stage::Evolve);
+            evo.select();
+            evo.breed();
+        }
+        evolveMs.v.push_back(st.wallMs[int(Stage::Evolve)]);
+        gens.v.push_back(1000.0 / evolveMs.v.back());
+    }
+    std::cout << "nsga2 select+breed, pop " << CFG::popSize << ": " << evolveMs.mean() << " ms ±"
+        << std::setprecision(1) << evolveMs.cv() << std::setprecision(2) << "%";
+    compare("nsga2/" + std::to_string(CFG::popSize), gens);
+    std::cout << "\n";
+
+    if (o.saveBaseline) {
+        std::ofstream out(o.saveBaseline);
+        out << "# --bench baseline: case, median evaluations/s (nsga2: generations/s), CV %\n"
+            << std::setprecision(6);
+        std::vector<std::string> keys;
+        for (auto& e : now) keys.push_back(e.first);
+        std::sort(keys.begin(), keys.end());
+        for (auto& k : keys) out << k << " " << now[k].rate << " " << now[k].cv << "\n";
+        if (!out) { std::cerr << "Cannot write " << o.saveBaseline << "\n"; return -1; }
+        std::cout << "Baseline written to " << o.saveBaseline << "\n";
+    }
+    if (slower) std::cout << slower << " case(s) more than " << 100.0 * CFG::benchTolerance
+        << "% (and 2× their CV) slower than " << o.baseline << "\n";
+    return slower ? 1 : 0;
+}
+
+// ─── --self-test ─────────────────────────────────────────────────────────────
+// What the fast paths promise to leave unchanged, checked on the --bench
+// scenes: one line per comparison, "ok" or the number of values that differ.
+static int runSelfTest(const Options& o)
+{
+    int failed = 0;
+    auto report = [&](const std::string& what, long long bad) {
+        std::cout << std::left << std::setw(44) << what << std::right;
+        if (bad) { std::cout << " FAIL, " << bad << " differ\n"; ++failed; }
+        else std::cout << " ok\n";
+    };
+
+    // SIMD span kernels vs. scalar: identical counts (needs -ffp-contract=off
+    // on GCC/Clang); an odd side exercises the scalar tails
+    CpuMandelbrotRenderer r(CFG::winW, CFG::winH, o.cpuThreads);
+    const SimdLevel best = bestSimd();
+    std::vector<std::uint16_t> ref;
+    for (const BenchScene& sc : benchScenes) {
+        const DeepView v = sceneView(sc);
+        if (v.zoom < CFG::deepZoomBelow) continue;   // perturbation: scalar only
+        r.setDeepZoom(false);
+        r.setView(v);
+        r.setMaxIter(1024);
+        for (int side : { 256, 251 })
+            for (bool interior : { false, true }) {
+                r.setResolution(side, side);
+                r.setInteriorCheck(interior);
+                r.setSimd(SimdLevel::Scalar);
+                r.renderOffscreen();
+                ref.assign(r.iterationPtr(), r.iterationPtr() + side * side);
+                for (SimdLevel l : { SimdLevel::SSE2, SimdLevel::AVX2 }) {
+                    if (int(l) > int(best)) continue;
+                    r.setSimd(l);
+                    r.renderOffscreen();
+                    long long bad = 0;
+                    for (int i = 0; i < side * side; ++i) bad += r.iterationPtr()[i] != ref[i];
+                    report(std::string("render ") + sc.name + " " + std::to_string(side) + "² "
+                        + simdNames[int(l)] + (interior ? " interior" : ""), bad);
+                }
+            }
+    }
+
+    // pixel statistics: SIMD row kernels (here maxCount < 2^15), banded over
+    // a pool, vs. one scalar pass (what maxCount ≥ 2^15 selects)
+    ThreadPool pool(o.cpuThreads);
+    for (const BenchScene& sc : benchScenes) {
+        const DeepView v = sceneView(sc);
+        r.setDeepZoom(v.zoom < CFG::deepZoomBelow);
+        r.setView(v);
+        r.setSimd(best);
+        r.setInteriorCheck(sc.interior);
+        for (int side : { 512, 251 }) {
+            r.setResolution(side, side);
+            r.renderOffscreen();
+            const PixelStats fast = pixelStats(r.iterationPtr(), side, side, 1024, &pool);
+            const PixelStats slow = pixelStats(r.iterationPtr(), side, 0, side, RenderBackend::MAX_ITER);
+            report(std::string("stats ") + sc.name + " " + std::to_string(side) + "² " + simdNames[int(best)],
+                (fast.edges != slow.edges) + (fast.sum != slow.sum) + (fast.sum2 != slow.sum2));
+        }
+    }
+    if (best == SimdLevel::Scalar) std::cout << "(no SIMD kernels on this CPU)\n";
+
+    // tile cache: 256² views whose pixels fall exactly on a tile level's
+    // grid compose to the counts of a direct render; going back to the first
+    // view is complete at once
+    TileCache tiles(std::size_t(CFG::tileCacheMB) << 20, CFG::tileThreads, true, false);
+    CpuMandelbrotRenderer direct(256, 256, o.cpuThreads);   // square, like the tile views
+    direct.setResolution(256, 256);
+    direct.setMaxIter(TileCache::keyIter(1024));
+    std::vector<std::uint16_t> counts;
+    struct { const char* name; double cx, cy; int level; } tileViews[] = {
+        { "full", -0.5, 0.0, 3 }, { "seahorse", -0.7436, 0.1318, 9 }, { "spiral", -0.7436, 0.1318, 14 },
+    };
+    DeepView first;
+    for (const auto& t : tileViews) {
+        const double scale = std::ldexp(TileCache::TILE / TileCache::ROOT, t.level);   // level pixels per unit
+        DeepView v;
+        v.cx = std::round(t.cx * scale) / scale; v.cy = std::round(t.cy * scale) / scale;
+        v.zoom = 256 / scale;
+        if (&t == tileViews) first = v;
+        auto t0 = std::chrono::steady_clock::now();
+        bool complete = false;
+        while (!(complete = tiles.compose(v, 1.0f, 1024, 256, 256, counts))
+            && std::chrono::steady_clock::now() - t0 < std::chrono::seconds(60))
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        direct.setView(v);
+        direct.renderOffscreen();
+        long long bad = complete ? 0 : 256 * 256;
+        for (int i = 0; complete && i < 256 * 256; ++i) bad += counts[i] != direct.iterationPtr()[i];
+        report(std::string("tiles ") + t.name + " level " + std::to_string(t.level), bad);
+    }
+    report("tiles revisit full, no rendering", !tiles.compose(first, 1.0f, 1024, 256, 256, counts));
+
+    std::cout << (failed ? std::to_string(failed) + " check(s) failed\n" : "All checks passed\n");
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) return -1;
+    if (opt.benchSort) return runSortBenchmark(opt);
+    if (opt.bench) return runBenchmark(opt);
+    if (opt.selfTest) return runSelfTest(opt);
+    if (opt.convert) return binaryLogToCsv(opt.convert, opt.csv) ? 0 : -1;
+    if (opt.workerHost) return runWorker(opt);
+
+    std::vector<char> snapshot;                  // --resume: options first, state in run*()
+    std::unique_ptr<ByteReader> resume;
+    if (opt.resume) {
+        if (!readSnapshot(opt.resume, snapshot)) return -1;
+        resume = std::make_unique<ByteReader>(snapshot);
+        if (!resumeOptions(*resume, opt)) return -1;
+    }
+    if (!opt.snapshotEvery) opt.snapshotEvery = CFG::snapshotEvery;
+    int rc = opt.headless ? runHeadless(opt, resume.get()) : runInteractive(opt, resume.get());
+    if (rc == 0 && opt.csv) {                    // the log is complete once run*() returns
+        if (!binaryLogToCsv(opt.log, opt.csv)) return -1;
+        std::cout << "CSV written to " << opt.csv << "\n";
+    }
+    return rc;
+}